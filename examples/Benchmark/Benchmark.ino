@@ -0,0 +1,134 @@
+/*
+OpenTherm bus benchmark: master and simulated slave on one controller
+
+The master sends requests back-to-back, the slave acknowledges them
+with configurable latency, jitter, dropped frames and UNKNOWN-DATAID replies.
+Every 10 seconds frames/s, round trip percentiles (request start to response end)
+and error counts are printed. Build with OPENTHERM_STATISTICS=1 for library statistics too.
+
+Hardware Connections:
+-master OpenTherm adapter: IN = pin 4, OUT = pin 2
+-slave (boiler side) OpenTherm adapter: IN = pin 5, OUT = pin 3
+-OpenTherm lines of both adapters connected to each other
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+OpenTherm master(2, 4);
+OpenTherm slave(3, 5, true);
+
+//simulated slave
+const unsigned int latency = 40; //ms after request, spec allows 20..800
+const unsigned int jitter = 10; //ms, +/-
+const byte dropPercent = 2; //requests without response
+const byte unknownPercent = 5; //requests answered with UNKNOWN-DATAID
+
+unsigned long pendingResponse;
+unsigned long pendingTimestamp;
+unsigned int pendingDelay;
+bool responsePending = false;
+
+const unsigned long requests[] = {
+	OpenTherm::buildSetBoilerStatusRequest(true, true),
+	OpenTherm::buildSetBoilerTemperatureRequest(OpenThermF88::fromInt(60)),
+	OpenTherm::buildGetBoilerTemperatureRequest(),
+	OpenTherm::buildReadRequest<Tret>(),
+};
+byte requestIndex = 0;
+
+//results
+const byte SAMPLES = 64;
+uint16_t roundTrips[SAMPLES]; //ms
+byte sampleCount = 0;
+byte sampleIndex = 0;
+unsigned long requestStart;
+unsigned long frames = 0;
+unsigned long errors[6]; //by OpenThermResponseStatus
+unsigned long reportTimestamp;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	if (status != OpenThermResponseStatus::SUCCESS || random(100) < dropPercent) return;
+	if (random(100) < unknownPercent) {
+		pendingResponse = OpenTherm::buildResponse(UNKNOWN_DATA_ID, OpenTherm::getDataID(request), OpenTherm::getData(request));
+	}
+	else if (OpenTherm::getMessageType(request) == WRITE_DATA) {
+		pendingResponse = OpenTherm::buildResponse(WRITE_ACK, OpenTherm::getDataID(request), OpenTherm::getData(request));
+	}
+	else {
+		pendingResponse = OpenTherm::buildResponse(READ_ACK, OpenTherm::getDataID(request), 0x3A80); //58.5
+	}
+	pendingTimestamp = millis();
+	pendingDelay = latency - jitter + random(2 * jitter + 1);
+	responsePending = true;
+}
+
+void handleResponse(unsigned long response, OpenThermResponseStatus status) {
+	frames++;
+	errors[status]++;
+	if (status == OpenThermResponseStatus::TIMEOUT) return;
+	roundTrips[sampleIndex] = (master.getLastFrameTimestamp() - requestStart) / 1000;
+	sampleIndex = (sampleIndex + 1) % SAMPLES;
+	if (sampleCount < SAMPLES) sampleCount++;
+}
+
+void printPercentile(const char *name, uint16_t *sorted, byte percent) {
+	Serial.print(name);
+	Serial.print(sorted[(sampleCount - 1) * percent / 100]);
+	Serial.print("ms");
+}
+
+void report() {
+	unsigned long elapsed = millis() - reportTimestamp;
+	uint16_t sorted[SAMPLES];
+	for (byte i = 0; i < sampleCount; i++) { //insertion sort
+		byte j = i;
+		for (; j > 0 && sorted[j - 1] > roundTrips[i]; j--) sorted[j] = sorted[j - 1];
+		sorted[j] = roundTrips[i];
+	}
+	Serial.print("frames/s=");
+	Serial.print(frames * 1000.0 / elapsed);
+	if (sampleCount > 0) {
+		printPercentile(" p50=", sorted, 50);
+		printPercentile(" p90=", sorted, 90);
+		printPercentile(" p99=", sorted, 99);
+	}
+	Serial.print(" ok=");
+	Serial.print(errors[OpenThermResponseStatus::SUCCESS]);
+	Serial.print(" unkn=");
+	Serial.print(errors[OpenThermResponseStatus::UNKNOWN_ID]);
+	Serial.print(" invalid=");
+	Serial.print(errors[OpenThermResponseStatus::INVALID]);
+	Serial.print(" timeout=");
+	Serial.println(errors[OpenThermResponseStatus::TIMEOUT]);
+#if OPENTHERM_STATISTICS
+	master.printStatistics(Serial);
+#endif
+	frames = 0;
+	for (byte i = 0; i < 6; i++) errors[i] = 0;
+	reportTimestamp = millis();
+}
+
+void setup() {
+	Serial.begin(115200);
+	Serial.println("Start");
+	slave.begin(handleRequest);
+	master.begin(handleResponse);
+	reportTimestamp = millis();
+}
+
+void loop() {
+	OpenTherm::processAll();
+	if (responsePending && millis() - pendingTimestamp >= pendingDelay) {
+		responsePending = false;
+		slave.sendResponse(pendingResponse);
+	}
+	if (master.isReady()) {
+		requestStart = micros();
+		master.sendRequestAync(requests[requestIndex]);
+		requestIndex = (requestIndex + 1) % (sizeof(requests) / sizeof(requests[0]));
+	}
+	if (millis() - reportTimestamp >= 10000) {
+		report();
+	}
+}
@@ -0,0 +1,44 @@
+/*
+OpenTherm footprint report
+
+Prints the RAM used by one OpenTherm instance with the features selected at build time,
+flash and global RAM usage are reported by the IDE / PlatformIO when compiling the sketch.
+Build it once per configuration to compare, e.g. a boiler only node (PlatformIO):
+build_flags = -DOPENTHERM_VENTILATION=0 -DOPENTHERM_CALLBACKS=0 -DOPENTHERM_STATISTICS=0
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+OpenTherm ot(4, 5);
+
+void printFeature(const char *name, int enabled) {
+	Serial.print(name);
+	Serial.println(enabled ? " on" : " off");
+}
+
+void setup() {
+	Serial.begin(115200);
+	printFeature("boiler", OPENTHERM_BOILER);
+	printFeature("ventilation", OPENTHERM_VENTILATION);
+	printFeature("callbacks", OPENTHERM_CALLBACKS);
+	printFeature("statistics", OPENTHERM_STATISTICS);
+	Serial.print("sizeof(OpenTherm)=");
+	Serial.println(sizeof(OpenTherm));
+	Serial.print("edge buffer=");
+	Serial.println(OPENTHERM_EDGE_BUFFER_SIZE * sizeof(uint16_t));
+
+	ot.begin();
+	//boiler status and setpoint, the only requests of a minimal node
+#if OPENTHERM_BOILER
+	ot.setBoilerStatus(true);
+	ot.setBoilerTemperature(OpenThermF88::fromInt(60));
+#else
+	ot.sendRequest(OpenTherm::buildSetBoilerStatusRequest(true));
+	ot.sendRequest(OpenTherm::buildSetBoilerTemperatureRequest(OpenThermF88::fromInt(60)));
+#endif
+}
+
+void loop() {
+	ot.process();
+}
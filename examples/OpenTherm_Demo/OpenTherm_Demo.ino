@@ -48,26 +48,33 @@ void loop()
 	unsigned long response = ot.setBoilerStatus(enableCentralHeating, enableHotWater, enableCooling);
 	OpenThermResponseStatus responseStatus = ot.getLastResponseStatus();
 	if (responseStatus == OpenThermResponseStatus::SUCCESS) {		
-		Serial.println("Central Heating: " + String(ot.isCentralHeatingEnabled(response) ? "on" : "off"));
-		Serial.println("Hot Water: " + String(ot.isHotWaterEnabled(response) ? "on" : "off"));
-		Serial.println("Flame: " + String(ot.isFlameOn(response) ? "on" : "off"));
+		Serial.print("Central Heating: ");
+		Serial.println(ot.isCentralHeatingEnabled(response) ? "on" : "off");
+		Serial.print("Hot Water: ");
+		Serial.println(ot.isHotWaterEnabled(response) ? "on" : "off");
+		Serial.print("Flame: ");
+		Serial.println(ot.isFlameOn(response) ? "on" : "off");
 	}
 	if (responseStatus == OpenThermResponseStatus::NONE) {
 		Serial.println("Error: OpenTherm is not initialized");
 	}
 	else if (responseStatus == OpenThermResponseStatus::INVALID) {
-		Serial.println("Error: Invalid response " + String(response, HEX));
+		Serial.print("Error: Invalid response ");
+		Serial.println(response, HEX);
 	}
 	else if (responseStatus == OpenThermResponseStatus::TIMEOUT) {
 		Serial.println("Error: Response timeout");
 	}
 
 	//Set Boiler Temperature to 64 degrees C
-	ot.setBoilerTemperature(64);
+	ot.setBoilerTemperature(OpenThermF88::fromInt(64));
 
 	//Get Boiler Temperature
-	float temperature = ot.getBoilerTemperature();
-	Serial.println("Boiler temperature is " + String(temperature) + " degrees C");	
+	char buffer[8];
+	OpenThermF88 temperature = ot.getFixedBoilerTemperature();
+	Serial.print("Boiler temperature is ");
+	Serial.print(temperature.toString(buffer));
+	Serial.println(" degrees C");
 
 	Serial.println();
 	delay(1000);
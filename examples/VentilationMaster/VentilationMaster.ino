@@ -31,22 +31,14 @@ but since GPIO6-GPIO11 are typically used to interface with the flash memory ICs
 
 #include <Arduino.h>
 #include <OpenTherm.h>
+#include <OpenThermScheduler.h>
+#include <OpenThermTransfer.h>
+#include <OpenThermTelemetry.h>
 
 const int inPin = 2; //4
 const int outPin = 3; //5
 OpenTherm ot(inPin, outPin);
-
-void handleInterrupt() {
-	ot.handleInterrupt();
-}
-
-void setup()
-{
-	Serial.begin(115200);
-	Serial.println("Start");
-	
-	ot.begin(handleInterrupt);
-}
+OpenThermScheduler scheduler(ot);
 
 static unsigned int masterProductVersionHi = 18;
 static unsigned int masterProductVersionLo =  2;
@@ -55,179 +47,136 @@ static unsigned int masterConfigurationHi  =  0;
 static unsigned int masterConfigurationLo  = 18;
 
 static VentilationLevel ventilationLevel = VL_NORMAL;
+static int setpointEntry = -1;
 
 static unsigned int configurationMemberId = 0;
 static unsigned int slaveProductVersionHi = 0;
 static unsigned int slaveProductVersionLo = 0;
 static unsigned int relativeVentilation   = 0;
 static unsigned int ventilationStatus    = 0;
-static unsigned int tspIndex = 0;
 
-static long supplyInletTemp  = -300;
-static long exhaustInletTemp = -300;
+static OpenThermF88 supplyInletTemp  = OpenThermF88::fromInt(-128);
+static OpenThermF88 exhaustInletTemp = OpenThermF88::fromInt(-128);
+static char temperatureBuffer[8];
+
+void handleTspChange(OpenThermMessageID id, byte index, byte value);
 
-// transparent client parameters.
+// transparent client parameters, Vitovent requests indeces 0,...,63 in a row and starts over at index 0.
 // 0: relative motor speed for VentilationLevel VL_REDUCED
 // 2: relative motor speed for VentilationLevel VL_NORMAL
 // 4: relative motor speed for VentilationLevel VL_HIGH
 // TODO: Find out what all other TSPs stand for.
-static short int tsps[] = {
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-};
-
-float toTemperature(unsigned long response) {
-    int hi = response & 0xff00;
-    unsigned lo = response & 0x00ff;
-
-    // TODO: Negative values probably wrong since I have no examples (my own supply inlet goes never below 0 degrees Celsius)
-    float result = 0.01*(100*lo/255) + hi;
-    return result;
-}
-
-static long unsigned loop_counter = 0;
-static long unsigned last_command_sent = 0;
+// Read in bus slots not used by scheduled requests, tsp.getValue(index) returns the last value.
+OpenThermTransfer tsp(TSPSizeVH, TspSettingsVH, 64, handleTspChange);
 
-void loop()
-{	
-    int step = loop_counter++;
-
-    unsigned long response;
-    OpenThermResponseStatus responseStatus;
-
-    last_command_sent = millis();
-
-    switch (step) {
+void handleInterrupt() {
+	ot.handleInterrupt();
+}
 
-    case 0:
-        Serial.println("-> getVentilationSlaveProductVersion()");
-        response = ot.getVentilationSlaveProductVersion();
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            slaveProductVersionHi = (response & 0xffff)>8;
-            slaveProductVersionLo = (response & 0x00ff);
-            Serial.println("Slave product version:      " + String(slaveProductVersionHi)  + "/" +  String(slaveProductVersionLo));
-        }
+void handleResponse(unsigned long response, OpenThermResponseStatus responseStatus) {
+    // B:OTMessage[READ_ACK,id:70,hi:1,lo:2,Status V/H]:0, use OpenThermTelemetry::write for compact binary records
+    if (responseStatus != OpenThermResponseStatus::SUCCESS) {
+        return;
+    }
+    OpenThermTelemetry::printMessage(Serial, response, 'B');
+    Serial.println();
+
+    switch (OpenTherm::getDataID(response)) {
+
+    case SlaveVersion: {
+        OpenThermBytes version = ot.getValue<SlaveVersion>(response);
+        slaveProductVersionHi = version.hb;
+        slaveProductVersionLo = version.lb;
+        Serial.print("Slave product version:      ");
+        Serial.print(slaveProductVersionHi);
+        Serial.print('/');
+        Serial.println(slaveProductVersionLo);
         break;
+    }
 
-    case 1:
-        Serial.println(String("-> setVentilationMasterProductVersion(") + masterProductVersionHi + "," + masterProductVersionLo + ")");
-        response = ot.setVentilationMasterProductVersion(masterProductVersionHi, masterProductVersionLo);
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            // TODO: Response ignored .. what should we do with the unit's answer?
+    case StatusVH:
+        ventilationStatus = response & 0xffff;
+        Serial.print("Ventilation status:         ");
+        Serial.println(ventilationStatus, BIN);
+        if (ot.isFilterCheck(ventilationStatus)) {
+            Serial.println("*** CHECK FILTER ***");
         }
         break;
 
-    case 2:
-        Serial.println(String("-> getVentilationTSPSetting(") + tspIndex + ")");
-        response = ot.getVentilationTSPSetting(tspIndex);
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            tsps[tspIndex] = response & 0xff;
-        }
-        // Vitovent requests TSP values for indeces 0,...,63 in a row an and starts over at index 0
-        tspIndex++;
-        if (tspIndex>63) {
-            tspIndex = 0;
-        }
+    case ConfigurationMemberidVH:
+        configurationMemberId = ot.getValue<ConfigurationMemberidVH>(response).lb;
+        Serial.print("Configuration member ID:    ");
+        Serial.println(configurationMemberId);
         break;
 
-    case 3:
-        Serial.println(String("-> setVentilationMasterConfiguration(") + masterConfigurationHi + "," + masterConfigurationLo + ")");
-        response = ot.setVentilationMasterConfiguration(masterConfigurationHi, masterConfigurationLo);
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            // TODO: Response ignored .. what should we do with the unit's answer?
-        }
+    case RelativeVentilationVH:
+        relativeVentilation = ot.getValue<RelativeVentilationVH>(response);
+        Serial.print("Relative ventilation level: ");
+        Serial.print(relativeVentilation);
+        Serial.println(" %");
         break;
 
-    case 4:
-        Serial.println("-> getVentilationStatus()");
-        response = ot.getVentilationStatus();
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            ventilationStatus = response & 0xffff;
-            Serial.println("Ventilation status:         " + String(ventilationStatus)   + " degrees C");
-            if (ot.isFilterCheck(ventilationStatus)) {
-                Serial.println("*** CHECK FILTER ***");
-            }
-        }
+    case TsupplyInletVH:
+        supplyInletTemp = ot.getValue<TsupplyInletVH>(response);
+        Serial.print("Supply  inlet  temperature: ");
+        Serial.print(supplyInletTemp.toString(temperatureBuffer));
+        Serial.println(" degrees C");
         break;
 
-    case 5:
-        Serial.println(String("-> setVentilationControlSetpoint(") + ventilationLevel + ")");
-        response = ot.setVentilationControlSetpoint(ventilationLevel);
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            // TODO: Response ignored .. what should we do with the unit's answer? Check if accepted? Just print/dump?
-        }
+    case TexhaustInletVH:
+        exhaustInletTemp = ot.getValue<TexhaustInletVH>(response);
+        Serial.print("Exhaust inlet  temperature: ");
+        Serial.print(exhaustInletTemp.toString(temperatureBuffer));
+        Serial.println(" degrees C");
         break;
 
-    case 6:
-        Serial.println("-> getVentilationConfigurationMemberId()");
-        response = ot.getVentilationConfigurationMemberId();
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            configurationMemberId = response & 0xff;
-            // TODO: Split config member ID into hi/lo?
-            Serial.println("Configuration member ID:    " + String(configurationMemberId));
-        }
+    default:
+        // TODO: Responses to writes ignored .. what should we do with the unit's answer? Check if accepted? Just print/dump?
         break;
+    }
+}
 
-    case 7:
-        Serial.println("-> getVentilationRelativeVentilation()");
-        response = ot.getVentilationRelativeVentilation();
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            relativeVentilation = response & 0xff;
-            Serial.println("Relative ventilation level: " + String(relativeVentilation) + " degrees C");
-        }
-        break;
+void handleTspChange(OpenThermMessageID id, byte index, byte value) {
+    Serial.print("TSP ");
+    Serial.print(index);
+    Serial.print(": ");
+    Serial.println(value);
+}
 
-    case 8:
-        Serial.println("-> getSupplyInletTemperature()");
-        response = ot.getSupplyInletTemperature();
-        if (ot.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS) {
-            supplyInletTemp = toTemperature(response);
-            Serial.println("Supply  inlet  temperature: " + String(supplyInletTemp)     + " degrees C");
-        }
-        break;
+void setup()
+{
+	Serial.begin(115200);
+	Serial.println("Start");
+	
+	ot.begin(handleInterrupt);
 
-    case 9:
-        Serial.println("-> getExhaustInletTemperature()");
-        response = ot.getExhaustInletTemperature();
-        if ((responseStatus = ot.getLastResponseStatus()) == OpenThermResponseStatus::SUCCESS) {
-            exhaustInletTemp = toTemperature(response);
-            Serial.println("Exhaust inlet  temperature: " + String(exhaustInletTemp)    + " degrees C");
-        }
-        break;
+	// Same requests the Vitovent 300 remote control sends, see log below.
+	// Scheduler sends them back-to-back whenever their period expires, higher priority first.
+	// Writes are only repeated when the value changes (scheduler.setData(setpointEntry, level))
+	// or once a minute to keep the unit configured, scheduler.isConfirmed tells if the unit acknowledged.
+	setpointEntry = scheduler.addWrite(OpenTherm::buildSetVentilationControlSetpoint(ventilationLevel), 60000, 2, handleResponse);
+	scheduler.add(OpenTherm::buildGetVentilationStatus(), 10000, 2, handleResponse);
+	scheduler.addRead<RelativeVentilationVH>(10000, 1, handleResponse);
+	scheduler.addRead<TsupplyInletVH>(10000, 1, handleResponse);
+	scheduler.addRead<TexhaustInletVH>(10000, 1, handleResponse);
+	scheduler.addRead<ConfigurationMemberidVH>(10000, 0, handleResponse);
+	scheduler.addWrite(OpenTherm::buildSetVentilationMasterProductVersion(masterProductVersionHi, masterProductVersionLo), 60000, 0, handleResponse);
+	scheduler.add(OpenTherm::buildGetVentilationSlaveProductVersion(), 10000, 0, handleResponse);
+	scheduler.addWrite(OpenTherm::buildSetVentilationMasterConfiguration(masterConfigurationHi, masterConfigurationLo), 60000, 0, handleResponse);
+	tsp.setInterval(600000); // re-read all TSPs every 10 minutes
+	scheduler.addTransfer(tsp);
+}
+
+void loop()
+{	
+    scheduler.process();
 
     /*
      * Probably unsupported (by my Vitovent300?) or at least never sent.
      * But maybe with those devices that support a summer bypass?
-    case 10:
-        response = ot.getSupplyInletTemperature();
-        break;
-
-    case 11:
-        response = ot.getExhaustInletTemperature();
-        break:
-    */
-
-    default:
-        // start over with step 0
-        loop_counter = 0;
-        return;
-    }
-
-    Serial.println(String("<- response=") + response + ", status=" + responseStatus);
-
-    unsigned long time_to_wait = 100; // ms
-    unsigned long now = millis();
-    if (now>last_command_sent) { // overflow possible on system time after 42 days
-        unsigned long execution_time = now-last_command_sent;
-        if (execution_time<900) {
-            time_to_wait = 900-execution_time;
-        }
-    }
-
-    delay(time_to_wait);
-
+     * scheduler.addRead<TsupplyOutletVH>(10000, 0, handleResponse);
+     * scheduler.addRead<TexhaustOutletVH>(10000, 0, handleResponse);
+     */
 }
 
 /*  Log from a Vitovent 300:
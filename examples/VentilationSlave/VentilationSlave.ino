@@ -0,0 +1,48 @@
+/*
+OpenTherm slave example: emulates a Vitovent 300 ventilation unit.
+
+Registers are answered by the library from the table below, values are
+taken from vitovent300.log.txt. Data-ids not in the table are answered
+with UNKNOWN-DATAID (like the real unit does for id 127).
+
+Controller input pin should support interrupts.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+const int inPin = 4;
+const int outPin = 5;
+OpenTherm ot(inPin, outPin, true);
+
+OpenThermRegister registers[] = {
+    { MConfigMMemberIDcode,    DIR_WRITE, 0x0012 },
+    { StatusVH,                DIR_READ,  0x0102 },
+    { ControlSetpointVH,       DIR_WRITE, 0x0002 },
+    { ConfigurationMemberidVH, DIR_READ,  0x0500 },
+    { RelativeVentilationVH,   DIR_READ,  0x0042 },
+    { TsupplyInletVH,          DIR_READ,  0x0A4C },
+    { TexhaustInletVH,         DIR_READ,  0x1399 },
+    { MasterVersion,           DIR_WRITE, 0x1202 },
+};
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+    if (status != OpenThermResponseStatus::SUCCESS) {
+        Serial.println("invalid request");
+        return;
+    }
+    if (OpenTherm::getDataID(request) == ControlSetpointVH && OpenTherm::getMessageType(request) == WRITE_DATA) {
+        Serial.print("ventilation level ");
+        Serial.println(OpenTherm::getDataLB(request));
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+    ot.setRegisters(registers, sizeof(registers) / sizeof(registers[0]));
+    ot.begin(handleRequest);
+}
+
+void loop() {
+    ot.process();
+}
@@ -0,0 +1,271 @@
+/*
+Arduino.cpp - virtual clock, pins and interrupts of the host build
+*/
+
+#include "Arduino.h"
+
+#define HOST_PINS 64
+
+HardwareSerial Serial;
+
+static unsigned long long now = 0;
+static uint8_t levels[HOST_PINS];
+static int connections[HOST_PINS][2]; //output pin -> input pins + 1, 0 - not connected
+static void (*handlers[HOST_PINS])(void);
+static void (*timerHandler)(void) = NULL;
+static unsigned long timerPeriod = 0;
+static unsigned long long timerNext = 0;
+static void (*backgroundTask)(void) = NULL;
+static bool inBackground = false;
+static void (*traceHandler)(uint8_t, uint8_t) = NULL;
+static unsigned long long randomState = 1;
+
+#if defined(__AVR__)
+volatile uint8_t SREG = 0x80;
+static volatile uint8_t portInputs[HOST_PINS / 8];
+static volatile uint8_t portOutputs[HOST_PINS / 8];
+
+static void setLevel(uint8_t pin, uint8_t level)
+{
+	levels[pin] = level;
+	uint8_t mask = 1 << (pin & 7);
+	if (level) {
+		portInputs[pin >> 3] |= mask;
+		portOutputs[pin >> 3] |= mask;
+	}
+	else {
+		portInputs[pin >> 3] &= ~mask;
+		portOutputs[pin >> 3] &= ~mask;
+	}
+}
+
+//output register writes of the library become pin changes (and interrupts on the connected input)
+static void syncPorts()
+{
+	for (uint8_t pin = 0; pin < HOST_PINS; pin++) {
+		if (connections[pin][0] == 0) continue;
+		uint8_t level = (portOutputs[pin >> 3] >> (pin & 7)) & 1;
+		if (level != levels[pin]) digitalWrite(pin, level);
+	}
+}
+
+void cli()
+{
+}
+
+void sei()
+{
+}
+
+volatile uint8_t *portInputRegister(uint8_t port)
+{
+	return &portInputs[port];
+}
+
+volatile uint8_t *portOutputRegister(uint8_t port)
+{
+	return &portOutputs[port];
+}
+
+void hostSleep()
+{
+	syncPorts();
+	unsigned long long wake = (now / 1024 + 1) * 1024;
+	if (timerHandler != NULL && timerNext < wake) wake = timerNext;
+	hostAdvance(wake - now);
+}
+#else
+static void setLevel(uint8_t pin, uint8_t level)
+{
+	levels[pin] = level;
+}
+
+static void syncPorts()
+{
+}
+#endif
+
+unsigned long long hostMicros()
+{
+	return now;
+}
+
+//fires timer interrupts due in the interval, then lets the background task run
+void hostAdvance(unsigned long us)
+{
+	unsigned long long end = now + us;
+	syncPorts();
+	while (timerHandler != NULL && timerNext <= end) {
+		now = timerNext;
+		timerNext += timerPeriod;
+		timerHandler();
+		syncPorts();
+	}
+	now = end;
+	if (backgroundTask != NULL && !inBackground) {
+		inBackground = true;
+		backgroundTask();
+		inBackground = false;
+	}
+}
+
+unsigned long micros()
+{
+	return (uint32_t)now; //wraps like a 32 bit controller
+}
+
+unsigned long millis()
+{
+	return (uint32_t)(now / 1000);
+}
+
+void delay(unsigned long ms)
+{
+	hostAdvance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	hostAdvance(us);
+}
+
+void yield()
+{
+	hostAdvance(1);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	(void)pin;
+	(void)mode;
+}
+
+int digitalRead(uint8_t pin)
+{
+	return pin < HOST_PINS ? levels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level)
+{
+	if (pin >= HOST_PINS) return;
+	level = level ? HIGH : LOW;
+	if (levels[pin] == level) return;
+	setLevel(pin, level);
+	if (traceHandler != NULL) traceHandler(pin, level);
+	for (int i = 0; i < 2 && connections[pin][i] != 0; i++) {
+		uint8_t in = connections[pin][i] - 1;
+		setLevel(in, !level);
+		if (handlers[in] != NULL) handlers[in]();
+	}
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode)
+{
+	(void)mode;
+	if (interrupt < HOST_PINS) handlers[interrupt] = handler;
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+	if (interrupt < HOST_PINS) handlers[interrupt] = NULL;
+}
+
+//interrupts only run inside digitalWrite and time advance, nothing to block
+void noInterrupts()
+{
+}
+
+void interrupts()
+{
+}
+
+void hostConnect(uint8_t outPin, uint8_t inPin)
+{
+	connections[outPin][connections[outPin][0] == 0 ? 0 : 1] = inPin + 1;
+	setLevel(outPin, levels[outPin]);
+	setLevel(inPin, !levels[outPin]);
+}
+
+void hostSetTimer(void (*handler)(void), unsigned long periodMicros)
+{
+	timerHandler = periodMicros > 0 ? handler : NULL;
+	timerPeriod = periodMicros;
+	timerNext = now + periodMicros;
+}
+
+void hostSetBackground(void (*task)(void))
+{
+	backgroundTask = task;
+}
+
+void hostSetTrace(void (*trace)(uint8_t pin, uint8_t level))
+{
+	traceHandler = trace;
+}
+
+long random(long max)
+{
+	if (max <= 0) return 0;
+	randomState = randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (long)((randomState >> 33) % (unsigned long)max);
+}
+
+long random(long min, long max)
+{
+	return max > min ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+	randomState = seed;
+}
+
+char *ultoa(unsigned long value, char *buffer, int radix)
+{
+	char digits[33];
+	int n = 0;
+	do {
+		byte digit = value % radix;
+		digits[n++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+		value /= radix;
+	} while (value > 0);
+	for (int i = 0; i < n; i++) buffer[i] = digits[n - 1 - i];
+	buffer[n] = 0;
+	return buffer;
+}
+
+char *utoa(unsigned int value, char *buffer, int radix)
+{
+	return ultoa(value, buffer, radix);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+	while (size--) n += write(*buffer++);
+	return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+	char buffer[8 * sizeof(long) + 1];
+	return write(ultoa(n, buffer, base < 2 ? 10 : base));
+}
+
+size_t Print::print(long n, int base)
+{
+	if (base == DEC && n < 0) return print('-') + printNumber(-(unsigned long)n, DEC);
+	return printNumber(base == DEC ? (unsigned long)n : (uint32_t)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+	return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+	return write(buffer);
+}
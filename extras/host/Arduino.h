@@ -0,0 +1,124 @@
+/*
+Arduino.h - host (Linux) stand-in for the Arduino API used by the library
+Time is virtual: micros()/millis() only move when delay, delayMicroseconds, yield or hostAdvance is called.
+Adapter pins are connected with hostConnect, writing an output pin changes the connected input pin
+and calls its interrupt handler right away, like a back to back pair of OpenTherm adapters.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define PROGMEM
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t level);
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void noInterrupts();
+void interrupts();
+
+#if defined(__AVR__)
+//port registers for the AVR build of the library (make avr-check), 8 pins per port,
+//writes to an output register reach the pin when time moves on
+extern volatile uint8_t SREG;
+void cli();
+void sei();
+#define digitalPinToPort(pin) ((pin) >> 3)
+#define digitalPinToBitMask(pin) (1 << ((pin) & 7))
+volatile uint8_t *portInputRegister(uint8_t port);
+volatile uint8_t *portOutputRegister(uint8_t port);
+void hostSleep(); //sleep_cpu: until the next timer interrupt or millis tick (1024us)
+#endif
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+char *utoa(unsigned int value, char *buffer, int radix);
+char *ultoa(unsigned long value, char *buffer, int radix);
+
+class Print
+{
+private:
+	size_t printNumber(unsigned long n, uint8_t base);
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *str) { return str == NULL ? 0 : write((const uint8_t *)str, strlen(str)); }
+
+	size_t print(const __FlashStringHelper *str) { return write((const char *)str); }
+	size_t print(const char str[]) { return write(str); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+	size_t print(int n, int base = DEC) { return print((long)n, base); }
+	size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+	size_t print(long n, int base = DEC);
+	size_t print(unsigned long n, int base = DEC);
+	size_t print(double n, int digits = 2);
+
+	size_t println() { return write("\r\n"); }
+	template<typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+	template<typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HardwareSerial : public Print
+{
+public:
+	void begin(unsigned long baud) { (void)baud; }
+	size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+	using Print::write;
+	operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+//host simulation
+void hostConnect(uint8_t outPin, uint8_t inPin); //output LOW (active) reads HIGH on the input, as through two adapters, up to 2 inputs
+void hostSetTimer(void (*handler)(void), unsigned long periodMicros); //periodic timer interrupt, 0 - off
+void hostSetBackground(void (*task)(void)); //runs whenever time moves on, e.g. another device on the bus
+void hostSetTrace(void (*trace)(uint8_t pin, uint8_t level)); //called for every output level change
+void hostAdvance(unsigned long us);
+unsigned long long hostMicros(); //64 bit virtual time
+
+#endif // Arduino_h
@@ -0,0 +1,71 @@
+/*
+SimSlave.cpp - simulated slave for host runs
+*/
+
+#include "SimSlave.h"
+
+SimSlave::SimSlave(OpenTherm &ot):
+	ot(ot),
+	pendingResponse(0),
+	pendingTimestamp(0),
+	pendingDelay(0),
+	responsePending(false),
+	registerCount(0),
+	latency(40),
+	jitter(0),
+	dropPercent(0),
+	unknownPercent(0),
+	requests(0)
+{
+}
+
+void SimSlave::setValue(OpenThermMessageID id, uint16_t value)
+{
+	for (byte i = 0; i < registerCount; i++) {
+		if (ids[i] == id) {
+			values[i] = value;
+			return;
+		}
+	}
+	if (registerCount == SIM_SLAVE_REGISTERS) return;
+	ids[registerCount] = id;
+	values[registerCount++] = value;
+}
+
+uint16_t SimSlave::getValue(OpenThermMessageID id)
+{
+	for (byte i = 0; i < registerCount; i++) {
+		if (ids[i] == id) return values[i];
+	}
+	return 0;
+}
+
+void SimSlave::handleRequest(unsigned long request, OpenThermResponseStatus status)
+{
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	requests++;
+	if (random(100) < dropPercent) return;
+	OpenThermMessageID id = OpenTherm::getDataID(request);
+	if (random(100) < unknownPercent) {
+		pendingResponse = OpenTherm::buildResponse(UNKNOWN_DATA_ID, id, OpenTherm::getData(request));
+	}
+	else if (OpenTherm::getMessageType(request) == WRITE_DATA) {
+		setValue(id, OpenTherm::getData(request));
+		pendingResponse = OpenTherm::buildResponse(WRITE_ACK, id, OpenTherm::getData(request));
+	}
+	else {
+		pendingResponse = OpenTherm::buildResponse(READ_ACK, id, getValue(id));
+	}
+	pendingTimestamp = millis();
+	pendingDelay = latency > jitter ? latency - jitter + random(2 * jitter + 1) : latency + random(jitter + 1);
+	responsePending = true;
+}
+
+void SimSlave::process()
+{
+	ot.process();
+	if (responsePending && millis() - pendingTimestamp >= pendingDelay) {
+		responsePending = false;
+		ot.sendResponse(pendingResponse);
+	}
+}
@@ -0,0 +1,40 @@
+/*
+SimSlave.h - simulated slave for host runs
+Answers requests received by a slave mode OpenTherm instance after a configurable latency with jitter,
+drops a share of them and answers another share with UNKNOWN-DATAID.
+READ_DATA is answered from a register table (0 for ids not in it), WRITE_DATA is acknowledged and stored.
+*/
+
+#ifndef SimSlave_h
+#define SimSlave_h
+
+#include <OpenTherm.h>
+
+#define SIM_SLAVE_REGISTERS 16
+
+class SimSlave
+{
+private:
+	OpenTherm &ot;
+	unsigned long pendingResponse;
+	unsigned long pendingTimestamp; //ms
+	unsigned int pendingDelay; //ms
+	bool responsePending;
+	byte ids[SIM_SLAVE_REGISTERS];
+	uint16_t values[SIM_SLAVE_REGISTERS];
+	byte registerCount;
+public:
+	unsigned int latency; //ms after request, library answers 20ms after the request at the earliest
+	unsigned int jitter; //ms, +/-
+	byte dropPercent;
+	byte unknownPercent;
+	unsigned long requests;
+
+	SimSlave(OpenTherm &ot);
+	void setValue(OpenThermMessageID id, uint16_t value);
+	uint16_t getValue(OpenThermMessageID id);
+	void handleRequest(unsigned long request, OpenThermResponseStatus status); //from the slave callback
+	void process(); //from the background task
+};
+
+#endif // SimSlave_h
@@ -0,0 +1,17 @@
+/*
+avr/sleep.h - host stand-in, sleep_cpu moves virtual time to the next interrupt
+*/
+
+#ifndef host_avr_sleep_h
+#define host_avr_sleep_h
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(uint8_t mode) { (void)mode; }
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+inline void sleep_cpu() { hostSleep(); }
+
+#endif // host_avr_sleep_h
@@ -0,0 +1,106 @@
+/*
+benchmark.cpp - master against a simulated slave on the virtual bus
+
+The master sends requests with sendRequest, the slave is a slave mode OpenTherm instance
+driven by SimSlave from the background task. Reports frames/s (virtual time), round trip
+percentiles (request start to response end), results by status, the time until a missing response
+was reported and host CPU time per frame. benchmark_fixed is the same with the library built with
+OPENTHERM_FIXED_TIMEOUT=1000000, the timing before the adaptive timeout.
+
+usage: benchmark [frames] [latency ms] [jitter ms] [drop %] [unknown %] [seed]
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <time.h>
+#include "SimSlave.h"
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+SimSlave sim(slave);
+unsigned long long requestStart;
+unsigned long long timeoutMicros = 0;
+unsigned long timeoutReports = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	sim.handleRequest(request, status);
+}
+
+//first TIMEOUT per request, a late response may follow
+void handleResponse(unsigned long response, OpenThermResponseStatus status) {
+	(void)response;
+	if (status == OpenThermResponseStatus::TIMEOUT) {
+		timeoutMicros += hostMicros() - requestStart;
+		timeoutReports++;
+	}
+}
+
+void background() {
+	sim.process();
+}
+
+int compare(const void *a, const void *b) {
+	unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+	return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv) {
+	unsigned long frames = argc > 1 ? atol(argv[1]) : 1000;
+	sim.latency = argc > 2 ? atoi(argv[2]) : 40;
+	sim.jitter = argc > 3 ? atoi(argv[3]) : 10;
+	sim.dropPercent = argc > 4 ? atoi(argv[4]) : 2;
+	sim.unknownPercent = argc > 5 ? atoi(argv[5]) : 5;
+	randomSeed(argc > 6 ? atol(argv[6]) : 1);
+
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	sim.setValue(Tboiler, 0x3A80);
+	sim.setValue(Tret, 0x2D00);
+	master.begin(handleResponse);
+	slave.begin(handleRequest);
+
+	const unsigned long requests[] = {
+		OpenTherm::buildSetBoilerStatusRequest(true, true),
+		OpenTherm::buildSetBoilerTemperatureRequest(OpenThermF88::fromInt(60)),
+		OpenTherm::buildGetBoilerTemperatureRequest(),
+		OpenTherm::buildReadRequest<Tret>(),
+	};
+	unsigned long *roundTrips = new unsigned long[frames];
+	unsigned long results[DATA_REJECTED + 1] = { 0 };
+	unsigned long samples = 0;
+
+	clock_t cpuStart = clock();
+	unsigned long long start = hostMicros();
+	for (unsigned long i = 0; i < frames; i++) {
+		requestStart = hostMicros();
+		master.sendRequest(requests[i % 4]);
+		OpenThermResponseStatus status = master.getLastResponseStatus();
+		results[status]++;
+		if (status != OpenThermResponseStatus::TIMEOUT) {
+			roundTrips[samples++] = (unsigned long)(master.getLastFrameTimestamp() - (uint32_t)requestStart);
+		}
+	}
+	double seconds = (hostMicros() - start) / 1e6;
+	double cpu = (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+
+	qsort(roundTrips, samples, sizeof(roundTrips[0]), compare);
+	printf("latency=%u+-%ums drop=%u%% unknown=%u%%\n", sim.latency, sim.jitter, sim.dropPercent, sim.unknownPercent);
+	printf("frames=%lu virtual=%.1fs frames/s=%.2f\n", frames, seconds, frames / seconds);
+	if (samples > 0) {
+		printf("round trip p50=%.1fms p90=%.1fms p99=%.1fms\n", roundTrips[samples / 2] / 1000.0,
+			roundTrips[samples * 9 / 10] / 1000.0, roundTrips[samples * 99 / 100] / 1000.0);
+	}
+	printf("ok=%lu unkn=%lu rejected=%lu invalid=%lu timeout=%lu\n", results[SUCCESS], results[UNKNOWN_ID],
+		results[DATA_REJECTED], results[INVALID], results[TIMEOUT]);
+	if (timeoutReports > 0) {
+		printf("missing response reported after %.1fms (mean), %lu late responses delivered\n",
+			timeoutMicros / 1000.0 / timeoutReports, timeoutReports - results[TIMEOUT]);
+	}
+	printf("host cpu=%.1fus/frame timeout now=%lums\n", cpu * 1e6 / frames, master.getResponseTimeout() / 1000);
+#if OPENTHERM_STATISTICS
+	master.printStatistics(Serial);
+#endif
+	delete[] roundTrips;
+	return 0;
+}
@@ -0,0 +1,73 @@
+/*
+cache_check.cpp - OpenThermCache with a busy bus and a failing slave
+
+While the bus is busy the cache must not send, must not change its entries and must return the
+last response it has (or report no value), read<ID> must not decode a missing response as 0.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <OpenThermCache.h>
+#include "SimSlave.h"
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+SimSlave sim(slave);
+OpenThermCache cache(master);
+int failures = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	sim.handleRequest(request, status);
+}
+
+void background() {
+	sim.process();
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+void waitReady() {
+	while (!master.isReady()) {
+		master.process();
+		delay(1);
+	}
+}
+
+int main() {
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	sim.latency = 40;
+	sim.jitter = 0;
+	sim.setValue(Tboiler, 0x3A80);
+	master.begin();
+	slave.begin(handleRequest);
+
+	OpenThermF88 value;
+	unsigned long requests = sim.requests;
+	master.sendRequestAync(OpenTherm::buildGetBoilerTemperatureRequest());
+	expect(!cache.read<Tboiler>(5000, value), "no value while busy before the first read");
+	expect(cache.getLastStatus(Tboiler) == OpenThermResponseStatus::NONE, "busy bus leaves the status as is");
+	waitReady();
+	expect(sim.requests == requests + 1, "nothing sent while busy");
+
+	expect(cache.read<Tboiler>(5000, value) && value.toFloat() == 58.5f, "read from the bus");
+	expect(cache.getLastStatus(Tboiler) == OpenThermResponseStatus::SUCCESS, "status SUCCESS");
+	delay(6000);
+	sim.setValue(Tboiler, 0x3C00);
+	master.sendRequestAync(OpenTherm::buildReadRequest<Tret>());
+	expect(cache.read<Tboiler>(5000, value) && value.toFloat() == 58.5f, "older value while busy");
+	expect(cache.getLastStatus(Tboiler) == OpenThermResponseStatus::SUCCESS, "older value keeps status SUCCESS");
+	waitReady();
+	expect(cache.read<Tboiler>(5000, value) && value.toFloat() == 60.0f, "refreshed when the bus is free");
+
+	sim.dropPercent = 100;
+	delay(6000);
+	value = OpenThermF88::fromInt(-1);
+	expect(!cache.read<Tboiler>(5000, value) && value.toFloat() == -1.0f, "timeout not decoded as value");
+	expect(cache.getLastStatus(Tboiler) == OpenThermResponseStatus::TIMEOUT, "status TIMEOUT");
+	return failures > 0;
+}
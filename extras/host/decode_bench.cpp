@@ -0,0 +1,117 @@
+/*
+decode_bench.cpp - edge recording and decoding of synthetic frames
+
+Random requests are played to a slave mode instance with a random half bit period per frame
+and jitter per edge. process() runs every poll interval (virtual time), a long interval stands
+for a sketch or another bus keeping process() away while the frame comes in, the edges then
+have to wait in the edge buffer. Reports decoded frames and host time of the interrupt
+handler per edge and of decoding per frame.
+
+usage: decode_bench [frames] [poll us] [min half bit us] [max half bit us] [jitter us] [worst case] [seed]
+worst case 1: READ_DATA id 0 data 0, a request with 66 edges
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <time.h>
+
+#define DRIVER_PIN 5
+
+OpenTherm slave(6, 7, true);
+unsigned long expected;
+unsigned long decoded = 0;
+unsigned long rejected = 0;
+unsigned long pollMicros;
+unsigned long long lastPoll = 0;
+double processSeconds = 0;
+double edgeSeconds = 0;
+unsigned long edgeCount = 0;
+unsigned long pollCount = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	if (status == OpenThermResponseStatus::SUCCESS && request == expected) decoded++;
+	else rejected++;
+}
+
+double seconds() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+//cost of one measurement, subtracted from the results
+double clockOverhead() {
+	double start = seconds();
+	for (int i = 0; i < 1000000; i++) seconds();
+	return (seconds() - start) / 1000000;
+}
+
+void poll() {
+	if (hostMicros() - lastPoll < pollMicros) return;
+	lastPoll = hostMicros();
+	double start = seconds();
+	slave.process();
+	processSeconds += seconds() - start;
+	pollCount++;
+}
+
+//advances in 100us steps so process() is polled on time
+void wait(unsigned long us) {
+	while (us > 0) {
+		unsigned long step = us < 100 ? us : 100;
+		delayMicroseconds(step);
+		us -= step;
+		poll();
+	}
+}
+
+//line level as set by setActiveState / setIdleState of the sender
+void edge(bool active) {
+	if (digitalRead(DRIVER_PIN) == (active ? LOW : HIGH)) return; //no edge between different bits
+	double start = seconds();
+	digitalWrite(DRIVER_PIN, active ? LOW : HIGH);
+	edgeSeconds += seconds() - start;
+	edgeCount++;
+}
+
+void sendHalfBits(bool high, unsigned int half, unsigned int jitter) {
+	edge(high);
+	wait(half + random(-(long)jitter, (long)jitter + 1));
+	edge(!high);
+	wait(half + random(-(long)jitter, (long)jitter + 1));
+}
+
+int main(int argc, char **argv) {
+	unsigned long frames = argc > 1 ? atol(argv[1]) : 10000;
+	pollMicros = argc > 2 ? atol(argv[2]) : 1000;
+	unsigned int minHalf = argc > 3 ? atoi(argv[3]) : 400;
+	unsigned int maxHalf = argc > 4 ? atoi(argv[4]) : 570;
+	unsigned int jitter = argc > 5 ? atoi(argv[5]) : 20;
+	bool worstCase = argc > 6 && atoi(argv[6]) != 0;
+	randomSeed(argc > 7 ? atol(argv[7]) : 1);
+
+	digitalWrite(DRIVER_PIN, HIGH);
+	hostConnect(DRIVER_PIN, 6);
+	slave.begin(handleRequest);
+
+	for (unsigned long i = 0; i < frames; i++) {
+		OpenThermRequestType type = random(2) ? OpenThermRequestType::READ : OpenThermRequestType::WRITE;
+		expected = worstCase ? OpenTherm::buildRequest(OpenThermRequestType::READ, (OpenThermMessageID)0, 0)
+			: OpenTherm::buildRequest(type, (OpenThermMessageID)random(256), random(0x10000));
+		unsigned int half = random(minHalf, maxHalf + 1);
+		sendHalfBits(true, half, jitter);
+		for (int bit = 31; bit >= 0; bit--) {
+			sendHalfBits(bitRead(expected, bit), half, jitter);
+		}
+		sendHalfBits(true, half, jitter);
+		wait(pollMicros + 40000); //slave answers after 20ms, nothing is sent here
+	}
+
+	printf("half bit=%u..%uus jitter=+-%uus poll=%luus edge buffer=%u\n", minHalf, maxHalf, jitter, pollMicros, OPENTHERM_EDGE_BUFFER_SIZE);
+	printf("edges/frame=%.1f\n", (double)edgeCount / frames);
+	printf("frames=%lu decoded=%lu rejected=%lu missed=%lu\n", frames, decoded, rejected, frames - decoded - rejected);
+	double overhead = clockOverhead();
+	printf("host time: edge (pin write + interrupt)=%.0fns process=%.2fus/frame in %.1f calls\n",
+		(edgeSeconds - edgeCount * overhead) * 1e9 / edgeCount, (processSeconds - pollCount * overhead) * 1e6 / frames, (double)pollCount / frames);
+	return 0;
+}
@@ -0,0 +1,106 @@
+/*
+f88_bench.cpp - OpenThermF88 against the float path it replaced
+
+decode: f8.8 data to hundredths for printing, build: setpoint to TSet data (clamped to 0..100),
+compare: value against a threshold. The float path is the code before OpenThermF88
+((data & 0xFFFF) / 256.0, temperatureToData(float)). All 65536 data values are decoded by both,
+the float path decodes negative values wrong. The host has an FPU, on AVR and ESP8266 every float
+operation is a soft-float call, see make size-report for the code it pulls in.
+
+usage: f88_bench [values] [seed]
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <time.h>
+
+__attribute__((noinline)) int floatDecode(unsigned int data) {
+	float value = (data & 0xFFFF) / 256.0;
+	return (int)(value * 100 + (value < 0 ? -0.5f : 0.5f));
+}
+
+__attribute__((noinline)) int fixedDecode(unsigned int data) {
+	return OpenThermF88::fromData(data).toHundredths();
+}
+
+__attribute__((noinline)) unsigned int floatBuild(float temperature) {
+	if (temperature < 0) temperature = 0;
+	if (temperature > 100) temperature = 100;
+	return (unsigned int)(temperature * 256);
+}
+
+__attribute__((noinline)) unsigned int fixedBuild(OpenThermF88 temperature) {
+	return OpenTherm::temperatureToData(temperature);
+}
+
+__attribute__((noinline)) bool floatCompare(unsigned int data) {
+	return (data & 0xFFFF) / 256.0 > 60.5;
+}
+
+__attribute__((noinline)) bool fixedCompare(unsigned int data) {
+	return OpenThermF88::fromData(data) > OpenThermF88::fromHundredths(6050);
+}
+
+double seconds() {
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	unsigned long count = argc > 1 ? atol(argv[1]) : 1000000;
+	randomSeed(argc > 2 ? atol(argv[2]) : 1);
+
+	unsigned long mismatches = 0, floatWrong = 0;
+	for (long data = 0; data < 0x10000; data++) {
+		float exact = (int16_t)data / 256.0f;
+		int hundredths = (int)(exact * 100 + (exact < 0 ? -0.5f : 0.5f));
+		if (fixedDecode(data) != hundredths) mismatches++;
+		if (floatDecode(data) != hundredths) floatWrong++;
+	}
+	unsigned long buildDiffers = 0;
+	for (long hundredths = -1000; hundredths <= 11000; hundredths++) {
+		if (fixedBuild(OpenThermF88::fromHundredths(hundredths)) != floatBuild(hundredths / 100.0f)) buildDiffers++;
+	}
+	printf("decode: %lu mismatches, float path wrong for %lu of 65536 values (negative)\n", mismatches, floatWrong);
+	printf("build: %lu of 12001 setpoints differ by 1/256 (float path truncates, fixed rounds)\n", buildDiffers);
+
+	unsigned int *data = new unsigned int[count];
+	float *floats = new float[count];
+	OpenThermF88 *fixed = new OpenThermF88[count];
+	for (unsigned long i = 0; i < count; i++) {
+		data[i] = random(0x10000);
+		long hundredths = random(12000) - 1000;
+		floats[i] = hundredths / 100.0f;
+		fixed[i] = OpenThermF88::fromHundredths(hundredths);
+	}
+
+	volatile unsigned long sink = 0;
+	double start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += floatDecode(data[i]);
+	double floatDecodeTime = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += fixedDecode(data[i]);
+	double fixedDecodeTime = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += floatBuild(floats[i]);
+	double floatBuildTime = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += fixedBuild(fixed[i]);
+	double fixedBuildTime = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += floatCompare(data[i]);
+	double floatCompareTime = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += fixedCompare(data[i]);
+	double fixedCompareTime = seconds() - start;
+
+	printf("values=%lu (host FPU)\n", count);
+	printf("decode:  float=%.2fns fixed=%.2fns\n", floatDecodeTime * 1e9 / count, fixedDecodeTime * 1e9 / count);
+	printf("build:   float=%.2fns fixed=%.2fns\n", floatBuildTime * 1e9 / count, fixedBuildTime * 1e9 / count);
+	printf("compare: float=%.2fns fixed=%.2fns\n", floatCompareTime * 1e9 / count, fixedCompareTime * 1e9 / count);
+	delete[] data;
+	delete[] floats;
+	delete[] fixed;
+	return mismatches > 0;
+}
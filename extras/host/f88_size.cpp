@@ -0,0 +1,26 @@
+/*
+f88_size.cpp - temperature handling of a sketch with float (F88_PATH=0) or OpenThermF88, used by make size-report
+Decodes a response to hundredths for printing, builds a setpoint request clamped to 0..100 and
+compares the value against a limit.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+#if F88_PATH
+unsigned long handleTemperature(unsigned long response, OpenThermF88 setpoint, int *hundredths, bool *overLimit) {
+	OpenThermF88 value = OpenThermF88::fromData(OpenTherm::getData(response));
+	*hundredths = value.toHundredths();
+	*overLimit = value > OpenThermF88::fromInt(80);
+	return OpenTherm::buildSetBoilerTemperatureRequest(setpoint);
+}
+#else
+unsigned long handleTemperature(unsigned long response, float setpoint, int *hundredths, bool *overLimit) {
+	float value = (response & 0xFFFF) / 256.0;
+	*hundredths = (int)(value * 100 + 0.5f);
+	*overLimit = value > 80;
+	if (setpoint < 0) setpoint = 0;
+	if (setpoint > 100) setpoint = 100;
+	return OpenTherm::buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::TSet, (unsigned int)(setpoint * 256));
+}
+#endif
@@ -0,0 +1,14 @@
+/*
+footprint.cpp - sizeof(OpenTherm) for the flags it is built with, used by make size-report
+Built with other flags than the library objects it has to fail to link, see make config-check.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+OpenTherm ot(4, 5);
+
+int main() {
+	printf("%u\n", (unsigned int)sizeof(OpenTherm));
+	return 0;
+}
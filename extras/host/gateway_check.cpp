@@ -0,0 +1,179 @@
+/*
+gateway_check.cpp - OpenThermGateway between a thermostat and a boiler on the simulated wire
+
+Forwarding, request and response overrides and injected requests, with the frame sources reported like
+in gateway logs. Two monitor instances listen on the thermostat lines, one per direction. A thermostat
+request arriving while an injected request is on the boiler bus must still get its response within
+800ms, also with a slow boiler.
+*/
+
+#include <Arduino.h>
+#include <OpenThermGateway.h>
+#include "SimSlave.h"
+
+#define THERMOSTAT_OUT 21
+#define GATEWAY_OUT 23
+
+OpenTherm thermostat(20, THERMOSTAT_OUT); //room unit, master
+OpenTherm gatewayThermostat(22, GATEWAY_OUT, true);
+OpenTherm gatewayBoiler(24, 25);
+OpenTherm boiler(26, 27, true);
+OpenTherm requestMonitor(28, -1, true);
+OpenTherm responseMonitor(29, -1, true);
+OpenThermGateway gateway(gatewayBoiler, gatewayThermostat);
+SimSlave sim(boiler);
+
+char sources[64];
+byte sourceCount = 0;
+unsigned long monitoredRequests = 0, monitoredResponses = 0, wrongDirection = 0;
+unsigned long long thermostatLastEdge, gatewayFirstEdge;
+unsigned long long maxTurnaround = 0;
+int failures = 0;
+
+void handleBoilerRequest(unsigned long request, OpenThermResponseStatus status) {
+	sim.handleRequest(request, status);
+}
+
+void handleThermostatRequest(unsigned long request, OpenThermResponseStatus status) {
+	gateway.handleRequest(request, status);
+}
+
+void handleFrame(unsigned long frame, char source, OpenThermResponseStatus status) {
+	(void)frame;
+	(void)status;
+	if (sourceCount < sizeof(sources) - 1) sources[sourceCount++] = source;
+	sources[sourceCount] = 0;
+}
+
+//a monitor sees the frames of its line only
+void handleMonitoredRequest(unsigned long frame, OpenThermResponseStatus status) {
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	if (OpenTherm::getMessageType(frame) <= WRITE_DATA || OpenTherm::getMessageType(frame) == INVALID_DATA) monitoredRequests++;
+	else wrongDirection++;
+}
+
+void handleMonitoredResponse(unsigned long frame, OpenThermResponseStatus status) {
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	if (OpenTherm::getMessageType(frame) >= READ_ACK) monitoredResponses++;
+	else wrongDirection++;
+}
+
+//more instances than OPENTHERM_MAX_BUSES, begin() fails for the monitors, they bring their own interrupt handlers
+void handleRequestMonitorInterrupt() {
+	requestMonitor.handleInterrupt();
+}
+
+void handleResponseMonitorInterrupt() {
+	responseMonitor.handleInterrupt();
+}
+
+void background() {
+	sim.process();
+	requestMonitor.process();
+	responseMonitor.process();
+}
+
+void trace(uint8_t pin, uint8_t level) {
+	(void)level;
+	if (pin == THERMOSTAT_OUT) {
+		thermostatLastEdge = hostMicros();
+		gatewayFirstEdge = 0;
+	}
+	else if (pin == GATEWAY_OUT && gatewayFirstEdge == 0) {
+		gatewayFirstEdge = hostMicros();
+		if (gatewayFirstEdge - thermostatLastEdge > maxTurnaround) maxTurnaround = gatewayFirstEdge - thermostatLastEdge;
+	}
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+//thermostat request through the gateway, the thermostat waits 100ms after the response like a real one
+unsigned long request(unsigned long frame) {
+	sourceCount = 0;
+	thermostat.sendRequestAync(frame);
+	while (!thermostat.isReady()) {
+		thermostat.process();
+		gateway.process();
+		delay(1);
+	}
+	return thermostat.getLastResponse();
+}
+
+void run(unsigned long ms) {
+	unsigned long start = millis();
+	while (millis() - start < ms) {
+		thermostat.process();
+		gateway.process();
+		delay(1);
+	}
+}
+
+int main() {
+	hostConnect(THERMOSTAT_OUT, 22);
+	hostConnect(THERMOSTAT_OUT, 28);
+	hostConnect(GATEWAY_OUT, 20);
+	hostConnect(GATEWAY_OUT, 29);
+	hostConnect(25, 26);
+	hostConnect(27, 24);
+	hostSetBackground(background);
+	hostSetTrace(trace);
+	sim.latency = 40;
+	sim.setValue(Tboiler, 0x3C00);
+	sim.setValue(Tret, 0x2D00);
+	bool started = thermostat.begin() && gatewayThermostat.begin(handleThermostatRequest) && gatewayBoiler.begin()
+		&& boiler.begin(handleBoilerRequest);
+	expect(started && !requestMonitor.begin(handleMonitoredRequest), "begin fails for a 5th instance without own interrupt handler");
+	expect(requestMonitor.begin(handleRequestMonitorInterrupt, handleMonitoredRequest)
+		&& responseMonitor.begin(handleResponseMonitorInterrupt, handleMonitoredResponse), "begin with own handler beyond OPENTHERM_MAX_BUSES");
+	gateway.setFrameCallback(handleFrame);
+
+	unsigned long response = request(OpenTherm::buildReadRequest<Tboiler>());
+	expect(thermostat.getLastResponseStatus() == SUCCESS && OpenTherm::getData(response) == 0x3C00, "read forwarded to the boiler and back");
+	expect(strcmp(sources, "TB") == 0, "frames reported as T, B");
+
+	gateway.setOverride(TSet, OVERRIDE_REQUEST, OpenThermF88::fromInt(45).toData());
+	request(OpenTherm::buildWriteRequest<TSet>(OpenThermF88::fromInt(60)));
+	expect(sim.getValue(TSet) == OpenThermF88::fromInt(45).toData(), "request override: boiler gets the overridden setpoint");
+	expect(strcmp(sources, "TRB") == 0, "frames reported as T, R, B");
+
+	gateway.setOverride(Tret, OVERRIDE_RESPONSE, 0x2800);
+	response = request(OpenTherm::buildReadRequest<Tret>());
+	expect(OpenTherm::getData(response) == 0x2800 && OpenTherm::getMessageType(response) == READ_ACK, "response override: thermostat gets the overridden value");
+	expect(strcmp(sources, "TBA") == 0, "frames reported as T, B, A");
+	gateway.clearOverride(Tret, OVERRIDE_RESPONSE);
+
+	unsigned long boilerRequests = sim.requests;
+	sourceCount = 0;
+	expect(gateway.inject(OpenTherm::buildReadRequest<Toutside>()), "inject accepted");
+	run(500);
+	expect(sim.requests == boilerRequests + 1 && strcmp(sources, "B") == 0, "injected request sent, response reported as B only");
+
+	printf("monitors: %lu requests, %lu responses, %lu on the wrong line\n", monitoredRequests, monitoredResponses, wrongDirection);
+	expect(monitoredRequests == 3 && monitoredResponses == 3 && wrongDirection == 0, "one monitor per direction sees all frames of its line");
+
+	//worst case: injected request starts on the boiler bus just before the thermostat request arrives
+	unsigned int latencies[] = { 40, 100, 350 };
+	for (unsigned int latency : latencies) {
+		sim.latency = latency;
+		for (int i = 0; i < 8; i++) request(OpenTherm::buildReadRequest<Tboiler>()); //boiler timeout adapts
+		boilerRequests = sim.requests;
+		maxTurnaround = 0;
+		unsigned long ok = 0;
+		for (int i = 0; i < 10; i++) {
+			gateway.inject(OpenTherm::buildReadRequest<Toutside>());
+			gateway.process();
+			request(OpenTherm::buildReadRequest<Tboiler>());
+			if (thermostat.getLastResponseStatus() == SUCCESS) ok++;
+		}
+		unsigned long injected = sim.requests - boilerRequests - 10;
+		printf("boiler latency %ums (timeout %lums): %lu injected, thermostat ok=%lu/10, longest wait for the response %llums\n",
+			latency, gatewayBoiler.getResponseTimeout() / 1000, injected, ok, maxTurnaround / 1000);
+		expect(ok == 10 && maxTurnaround < 800000, "thermostat response within 800ms");
+		expect(latency > 200 ? injected == 0 : injected == 10, latency > 200 ? "injection held back for a slow boiler" : "injected requests sent");
+		run(2000);
+	}
+	return failures > 0;
+}
@@ -0,0 +1,143 @@
+/*
+log_bench.cpp - gateway log parser and frame log on a recorded log
+
+Parses the log (vitovent300.log.txt by default) into request/response pairs, parses it repeatedly
+for throughput, appends the pairs to an OpenThermFrameLog at the given spacing and prints them
+back as gateway log text, which must parse to the same pairs and match the text of the log.
+
+usage: log_bench [log file] [parser repeats] [spacing ms] [append repeats]
+*/
+
+#include <Arduino.h>
+#include <OpenThermLogParser.h>
+#include <OpenThermFrameLog.h>
+#include <time.h>
+
+#define MAX_PAIRS 10000
+#define FRAME_LOG_SIZE 16384
+
+struct Pair {
+	unsigned long request;
+	unsigned long response;
+	OpenThermResponseStatus status;
+};
+
+Pair pairs[MAX_PAIRS];
+Pair printed[MAX_PAIRS];
+unsigned long pairCount = 0;
+unsigned long printedCount = 0;
+byte frameLogBuffer[FRAME_LOG_SIZE];
+
+void collect(unsigned long request, unsigned long response, OpenThermResponseStatus status) {
+	if (pairCount < MAX_PAIRS) pairs[pairCount++] = { request, response, status };
+}
+
+void collectPrinted(unsigned long request, unsigned long response, OpenThermResponseStatus status) {
+	if (printedCount < MAX_PAIRS) printed[printedCount++] = { request, response, status };
+}
+
+void ignore(unsigned long, unsigned long, OpenThermResponseStatus) {
+}
+
+//gateway text printed by the frame log reader
+class TextBuffer : public Print
+{
+public:
+	char *text;
+	size_t size;
+	size_t length;
+	TextBuffer(size_t size): text(new char[size]), size(size), length(0) {}
+	~TextBuffer() { delete[] text; }
+	size_t write(uint8_t c) {
+		if (length == size) return 0;
+		text[length++] = c;
+		return 1;
+	}
+	using Print::write;
+};
+
+double seconds() {
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "../../vitovent300.log.txt";
+	unsigned long repeats = argc > 2 ? atol(argv[2]) : 200;
+	unsigned long spacing = argc > 3 ? atol(argv[3]) : 190;
+	unsigned long appendRepeats = argc > 4 ? atol(argv[4]) : 1000;
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("cannot open %s\n", path);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	size_t size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	uint8_t *text = new uint8_t[size];
+	size_t read = fread(text, 1, size, file);
+	fclose(file);
+	if (read != size) return 1;
+
+	OpenThermLogParser parser(collect);
+	parser.write(text, size);
+	parser.end();
+	unsigned long results[DATA_REJECTED + 1] = { 0 };
+	for (unsigned long i = 0; i < pairCount; i++) results[pairs[i].status]++;
+	printf("%s: %lu bytes, %lu frames, %lu invalid, %lu pairs: ok=%lu unkn=%lu rejected=%lu invalid=%lu no response=%lu\n",
+		path, (unsigned long)size, parser.getFrameCount(), parser.getInvalidCount(), pairCount, results[SUCCESS],
+		results[UNKNOWN_ID], results[DATA_REJECTED], results[INVALID], results[TIMEOUT]);
+
+	OpenThermLogParser throughput(ignore);
+	double start = seconds();
+	for (unsigned long i = 0; i < repeats; i++) throughput.write(text, size);
+	throughput.end();
+	double elapsed = seconds() - start;
+	printf("parser: %.0f MB in %.2fs, %.1f MB/s, %.2f M frames/s\n", size * (double)repeats / 1e6, elapsed,
+		size * (double)repeats / 1e6 / elapsed, throughput.getFrameCount() / 1e6 / elapsed);
+
+	OpenThermFrameLog log(frameLogBuffer, sizeof(frameLogBuffer));
+	for (unsigned long i = 0; i < pairCount; i++) {
+		log.append(i * spacing, pairs[i].request, pairs[i].response, pairs[i].status);
+	}
+	unsigned long frames = 0;
+	for (unsigned long i = 0; i < pairCount; i++) frames += pairs[i].status == TIMEOUT ? 1 : 2;
+	printf("frame log: block=%u spacing=%lums %u bytes, %.2f bytes/frame, gateway text %.1f bytes/frame\n",
+		OPENTHERM_FRAME_LOG_BLOCK_SIZE, spacing, log.getUsedBytes(), (double)log.getUsedBytes() / frames, (double)size / frames);
+
+	TextBuffer out(size * 2);
+	OpenThermFrameLogReader reader(log);
+	reader.print(out);
+	OpenThermLogParser again(collectPrinted);
+	again.write((const uint8_t *)out.text, out.length);
+	again.end();
+	bool same = printedCount == pairCount;
+	for (unsigned long i = 0; same && i < pairCount; i++) {
+		same = printed[i].request == pairs[i].request && printed[i].status == pairs[i].status
+			&& (pairs[i].status == TIMEOUT || printed[i].response == pairs[i].response);
+	}
+	//Print ends lines with \r\n, the log with \n
+	size_t length = 0;
+	for (size_t i = 0; i < out.length; i++) {
+		if (out.text[i] != '\r') out.text[length++] = out.text[i];
+	}
+	bool identical = memmem(text, size, out.text, length) != NULL;
+	printf("round trip: %lu pairs, %s, text %s\n", printedCount, same ? "same pairs" : "DIFFERENT",
+		identical ? "identical to the log (without line ends, lines outside pairs)" : "differs from the log");
+
+	OpenThermFrameLog appendLog(frameLogBuffer, sizeof(frameLogBuffer));
+	start = seconds();
+	unsigned long timestamp = 0;
+	for (unsigned long r = 0; r < appendRepeats; r++) {
+		for (unsigned long i = 0; i < pairCount; i++) {
+			appendLog.append(timestamp, pairs[i].request, pairs[i].response, pairs[i].status);
+			timestamp += spacing;
+		}
+	}
+	elapsed = seconds() - start;
+	printf("append: %.1fns/pair\n", elapsed * 1e9 / (appendRepeats * pairCount));
+	delete[] text;
+	return same && identical ? 0 : 1;
+}
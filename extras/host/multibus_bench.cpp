@@ -0,0 +1,112 @@
+/*
+multibus_bench.cpp - frames/s of one bus against two buses served from one loop
+
+One bus: blocking sendRequest calls. Two buses: sendRequestAync on whichever bus is ready,
+OpenTherm::processAll and waitForEvent in the loop, so the response and delay window of one
+bus is used by the other. Each bus has its own SimSlave.
+
+usage: multibus_bench [frames per bus] [latency ms] [jitter ms] [master timer transmit 0/1] [seed]
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <time.h>
+#include "SimSlave.h"
+
+OpenTherm master1(4, 5);
+OpenTherm master2(8, 9);
+OpenTherm slave1(6, 7, true);
+OpenTherm slave2(10, 11, true);
+SimSlave sim1(slave1);
+SimSlave sim2(slave2);
+unsigned long completed[2] = { 0, 0 };
+unsigned long succeeded = 0;
+
+void handleRequest1(unsigned long request, OpenThermResponseStatus status) {
+	sim1.handleRequest(request, status);
+}
+
+void handleRequest2(unsigned long request, OpenThermResponseStatus status) {
+	sim2.handleRequest(request, status);
+}
+
+void count(int bus, OpenThermResponseStatus status) {
+	completed[bus]++;
+	if (status == OpenThermResponseStatus::SUCCESS) succeeded++;
+}
+
+void handleResponse1(unsigned long response, OpenThermResponseStatus status) {
+	(void)response;
+	count(0, status);
+}
+
+void handleResponse2(unsigned long response, OpenThermResponseStatus status) {
+	(void)response;
+	count(1, status);
+}
+
+void background() {
+	sim1.process();
+	sim2.process();
+}
+
+double cpuSeconds() {
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+void report(const char *name, unsigned long frames, unsigned long long start, double cpuStart) {
+	double seconds = (hostMicros() - start) / 1e6;
+	printf("%-10s frames=%lu ok=%lu virtual=%.1fs frames/s=%.2f host cpu=%.1fus/frame\n", name, frames, succeeded, seconds,
+		frames / seconds, (cpuSeconds() - cpuStart) * 1e6 / frames);
+}
+
+int main(int argc, char **argv) {
+	unsigned long frames = argc > 1 ? atol(argv[1]) : 500;
+	sim1.latency = sim2.latency = argc > 2 ? atoi(argv[2]) : 40;
+	sim1.jitter = sim2.jitter = argc > 3 ? atoi(argv[3]) : 10;
+	bool timer = argc > 4 && atoi(argv[4]) != 0;
+	randomSeed(argc > 5 ? atol(argv[5]) : 1);
+
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostConnect(9, 10);
+	hostConnect(11, 8);
+	hostSetBackground(background);
+	master1.begin(handleResponse1);
+	master2.begin(handleResponse2);
+	slave1.begin(handleRequest1);
+	slave2.begin(handleRequest2);
+	//slaves are separate devices, their transmit must not stop the masters
+	slave1.setTransmitTimer(true);
+	slave2.setTransmitTimer(true);
+	hostSetTimer(OpenTherm::handleTimerAll, 500);
+	master1.setTransmitTimer(timer);
+	master2.setTransmitTimer(timer);
+	const unsigned long request = OpenTherm::buildGetBoilerTemperatureRequest();
+	printf("latency=%u+-%ums master transmit=%s\n", sim1.latency, sim1.jitter, timer ? "timer" : "blocking");
+
+	unsigned long long start = hostMicros();
+	double cpuStart = cpuSeconds();
+	for (unsigned long i = 0; i < frames; i++) {
+		master1.sendRequest(request);
+	}
+	report("one bus", frames, start, cpuStart);
+
+	completed[0] = completed[1] = succeeded = 0;
+	unsigned long sent[2] = { 0, 0 };
+	OpenTherm *buses[2] = { &master1, &master2 };
+	start = hostMicros();
+	cpuStart = cpuSeconds();
+	while (completed[0] < frames || completed[1] < frames) {
+		for (int bus = 0; bus < 2; bus++) {
+			if (sent[bus] < frames && sent[bus] == completed[bus] && buses[bus]->isReady()) {
+				buses[bus]->sendRequestAync(request);
+				sent[bus]++;
+			}
+		}
+		OpenTherm::processAll();
+		OpenTherm::waitForEvent();
+	}
+	report("two buses", 2 * frames, start, cpuStart);
+	return 0;
+}
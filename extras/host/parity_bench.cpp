@@ -0,0 +1,130 @@
+/*
+parity_bench.cpp - frame codec against the implementation it replaced
+
+parity: XOR fold against the bit-by-bit loop, build: buildRequest, valid: isValidResponse,
+decode: Tboiler of a response (valid check and f8.8 data, getTemperature before, getValue now).
+The previous functions are copied with 32 bit frames as on AVR and ESP8266. All run over the same
+random frames, results must match (decode compares the raw data, see f88_bench for the float values).
+
+usage: parity_bench [frames] [seed]
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <time.h>
+
+static_assert(OpenTherm::buildGetBoilerTemperatureRequest() == 0x80190000, "request folds to a constant");
+
+__attribute__((noinline)) bool loopParity(uint32_t frame) {
+	byte p = 0;
+	while (frame > 0) {
+		if (frame & 1) p++;
+		frame = frame >> 1;
+	}
+	return (p & 1);
+}
+
+__attribute__((noinline)) bool foldParity(uint32_t frame) {
+	return OpenTherm::parity(frame);
+}
+
+__attribute__((noinline)) uint32_t loopBuild(OpenThermRequestType type, OpenThermMessageID id, unsigned int data) {
+	uint32_t request = data;
+	if (type == OpenThermRequestType::WRITE) {
+		request |= 1ul << 28;
+	}
+	request |= ((uint32_t)id) << 16;
+	if (loopParity(request)) request |= (1ul << 31);
+	return request;
+}
+
+__attribute__((noinline)) uint32_t foldBuild(OpenThermRequestType type, OpenThermMessageID id, unsigned int data) {
+	return OpenTherm::buildRequest(type, id, data);
+}
+
+__attribute__((noinline)) bool loopValid(uint32_t response) {
+	if (loopParity(response)) return false;
+	byte msgType = (uint32_t)(response << 1) >> 29;
+	return msgType == 4 || msgType == 5; //4 - read, 5 - write
+}
+
+__attribute__((noinline)) bool foldValid(uint32_t response) {
+	return OpenTherm::isValidResponse(response);
+}
+
+__attribute__((noinline)) float loopDecode(uint32_t response) {
+	return loopValid(response) ? (response & 0xFFFF) / 256.0 : 0;
+}
+
+__attribute__((noinline)) OpenThermF88 foldDecode(uint32_t response) {
+	return OpenTherm::isValidResponse(response) ? OpenTherm::getValue<Tboiler>(response) : OpenThermF88::fromInt(0);
+}
+
+double seconds() {
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	unsigned long count = argc > 1 ? atol(argv[1]) : 1000000;
+	randomSeed(argc > 2 ? atol(argv[2]) : 1);
+	uint32_t *frames = new uint32_t[count];
+	uint32_t *responses = new uint32_t[count];
+	for (unsigned long i = 0; i < count; i++) {
+		frames[i] = ((uint32_t)random(0x10000) << 16) | random(0x10000);
+		//half of them valid responses, the rest with wrong parity or message type
+		uint32_t response = OpenTherm::buildResponse(random(2) ? READ_ACK : WRITE_ACK, (OpenThermMessageID)random(256), random(0x10000));
+		responses[i] = i % 2 ? response : response ^ (i % 4 == 1 ? 1ul << 31 : 1ul << 28);
+	}
+	OpenThermRequestType types[] = { OpenThermRequestType::READ, OpenThermRequestType::WRITE };
+
+	unsigned long mismatches[4] = { 0, 0, 0, 0 };
+	unsigned long valid = 0;
+	for (unsigned long i = 0; i < count; i++) {
+		OpenThermMessageID id = (OpenThermMessageID)(frames[i] >> 16 & 0xFF);
+		if (loopParity(frames[i]) != foldParity(frames[i])) mismatches[0]++;
+		if (loopBuild(types[i & 1], id, frames[i] & 0xFFFF) != foldBuild(types[i & 1], id, frames[i] & 0xFFFF)) mismatches[1]++;
+		if (loopValid(responses[i]) != foldValid(responses[i])) mismatches[2]++;
+		if ((unsigned int)(loopDecode(responses[i]) * 256) != foldDecode(responses[i]).toData()) mismatches[3]++;
+		if (foldValid(responses[i])) valid++;
+	}
+
+	volatile unsigned long sink = 0;
+	double loop[4], fold[4];
+	double start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += loopParity(frames[i]);
+	loop[0] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += foldParity(frames[i]);
+	fold[0] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += loopBuild(types[i & 1], (OpenThermMessageID)(frames[i] >> 16 & 0xFF), frames[i] & 0xFFFF);
+	loop[1] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += foldBuild(types[i & 1], (OpenThermMessageID)(frames[i] >> 16 & 0xFF), frames[i] & 0xFFFF);
+	fold[1] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += loopValid(responses[i]);
+	loop[2] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += foldValid(responses[i]);
+	fold[2] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += loopDecode(responses[i]);
+	loop[3] = seconds() - start;
+	start = seconds();
+	for (unsigned long i = 0; i < count; i++) sink += foldDecode(responses[i]).toData();
+	fold[3] = seconds() - start;
+
+	const char *names[] = { "parity", "build", "valid", "decode" };
+	printf("frames=%lu (%lu valid responses)\n", count, valid);
+	unsigned long total = 0;
+	for (int i = 0; i < 4; i++) {
+		printf("%-7s loop=%.2fns/frame fold=%.2fns/frame mismatches=%lu\n", names[i], loop[i] * 1e9 / count, fold[i] * 1e9 / count, mismatches[i]);
+		total += mismatches[i];
+	}
+	delete[] frames;
+	delete[] responses;
+	return total > 0;
+}
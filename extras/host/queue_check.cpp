@@ -0,0 +1,130 @@
+/*
+queue_check.cpp - OpenThermQueue with producers on std::threads
+
+Claim race: the threads submit into an empty queue at the same time, every slot must be claimed
+by exactly one submit. Bus: the threads submit write requests with their own values, polled and
+with callback, while the main thread runs process() on the simulated bus. Every request must get
+the response to its own value.
+The AVR build claims slots with interrupts off (single core), there the producers run one at a time.
+*/
+
+#include <Arduino.h>
+#include <OpenThermQueue.h>
+#include <atomic>
+#include <thread>
+#include "SimSlave.h"
+
+#if defined(__AVR__)
+#define PRODUCERS 1
+#else
+#define PRODUCERS 4
+#endif
+#define ROUNDS 2000
+#define REQUESTS 20 //per producer on the bus
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+SimSlave sim(slave);
+OpenThermQueue queue(master);
+std::atomic<int> ready(0);
+std::atomic<bool> start(false);
+std::atomic<int> finished(0);
+std::atomic<int> callbackMatches[PRODUCERS];
+std::atomic<int> mismatches(0);
+int failures = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	sim.handleRequest(request, status);
+}
+
+void background() {
+	sim.process();
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+void claim(OpenThermQueue *target, int *handles) {
+	ready++;
+	while (!start) std::this_thread::yield();
+	for (int i = 0; i < 2 * OPENTHERM_QUEUE_SIZE / PRODUCERS; i++) {
+		handles[i] = target->submit(OpenTherm::buildRequest(OpenThermRequestType::WRITE, TSet, i));
+	}
+}
+
+uint16_t valueOf(int producer, int i) {
+	return (producer << 8) | i;
+}
+
+void handleResponse(int handle, unsigned long response, OpenThermResponseStatus status) {
+	(void)handle;
+	int producer = OpenTherm::getData(response) >> 8;
+	if (status == OpenThermResponseStatus::SUCCESS && producer < PRODUCERS) callbackMatches[producer]++;
+	else mismatches++;
+}
+
+//even requests are polled, odd ones completed by callback
+void produce(int producer) {
+	for (int i = 0; i < REQUESTS; i++) {
+		unsigned long request = OpenTherm::buildRequest(OpenThermRequestType::WRITE, TSet, valueOf(producer, i));
+		int handle;
+		while ((handle = queue.submit(request, i & 1 ? handleResponse : NULL)) < 0) std::this_thread::yield();
+		if (i & 1) continue;
+		while (!queue.isDone(handle)) std::this_thread::yield();
+		if (queue.getResponseStatus(handle) != OpenThermResponseStatus::SUCCESS
+			|| OpenTherm::getData(queue.getResponse(handle)) != valueOf(producer, i)) mismatches++;
+		queue.release(handle);
+	}
+	finished++;
+}
+
+int main() {
+	int collisions = 0, wrongCounts = 0;
+	for (int round = 0; round < ROUNDS; round++) {
+		OpenThermQueue fresh(master);
+		int handles[PRODUCERS][2 * OPENTHERM_QUEUE_SIZE];
+		std::thread threads[PRODUCERS];
+		ready = 0;
+		start = false;
+		for (int t = 0; t < PRODUCERS; t++) threads[t] = std::thread(claim, &fresh, handles[t]);
+		while (ready < PRODUCERS) std::this_thread::yield();
+		start = true;
+		for (int t = 0; t < PRODUCERS; t++) threads[t].join();
+		int claimed[OPENTHERM_QUEUE_SIZE] = { 0 };
+		int count = 0;
+		for (int t = 0; t < PRODUCERS; t++) {
+			for (int i = 0; i < 2 * OPENTHERM_QUEUE_SIZE / PRODUCERS; i++) {
+				if (handles[t][i] < 0) continue;
+				count++;
+				if (claimed[handles[t][i] & 0x0F]++ > 0) collisions++;
+			}
+		}
+		if (count != OPENTHERM_QUEUE_SIZE || fresh.pendingCount() != OPENTHERM_QUEUE_SIZE) wrongCounts++;
+	}
+	printf("claim race: %d rounds, %d producers, %d slots\n", ROUNDS, PRODUCERS, OPENTHERM_QUEUE_SIZE);
+	expect(collisions == 0, "no slot claimed twice");
+	expect(wrongCounts == 0, "queue filled exactly, the other submits get -1");
+
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	master.begin();
+	slave.begin(handleRequest);
+	for (int t = 0; t < PRODUCERS; t++) callbackMatches[t] = 0;
+	std::thread threads[PRODUCERS];
+	for (int t = 0; t < PRODUCERS; t++) threads[t] = std::thread(produce, t);
+	while (finished < PRODUCERS || queue.pendingCount() > 0 || !master.isReady()) {
+		queue.process();
+		delay(1);
+	}
+	for (int t = 0; t < PRODUCERS; t++) threads[t].join();
+	printf("bus: %d producers, %d requests each, %lu frames\n", PRODUCERS, REQUESTS, sim.requests);
+	expect(mismatches == 0, "every polled request got its own response");
+	bool callbacks = true;
+	for (int t = 0; t < PRODUCERS; t++) callbacks = callbacks && callbackMatches[t] == REQUESTS / 2;
+	expect(callbacks, "every callback got a response of its producer");
+	expect(sim.requests == PRODUCERS * REQUESTS, "each request sent once");
+	return failures > 0;
+}
@@ -0,0 +1,92 @@
+/*
+replay_check.cpp - recorded gateway log replayed to a master on the simulated wire
+
+The log (vitovent300.log.txt by default) is parsed into OpenThermLogReplay, which has to keep every
+distinct request. The master then sends each logged request in log order and must get the latest
+recorded response of it, ids not in the log get UNKNOWN-DATAID.
+
+usage: replay_check [log file]
+*/
+
+#include <Arduino.h>
+#include <OpenThermLogParser.h>
+#include <OpenThermLogReplay.h>
+
+#define MAX_PAIRS 2000
+
+struct Pair {
+	unsigned long request;
+	unsigned long response;
+};
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+OpenThermLogReplay replay(slave);
+Pair pairs[MAX_PAIRS];
+unsigned long pairCount = 0;
+unsigned long distinct = 0;
+int failures = 0;
+
+//what the replay stores: latest response of each request
+void storePair(unsigned long request, unsigned long response, OpenThermResponseStatus status) {
+	replay.store(request, response, status);
+	if (status == OpenThermResponseStatus::TIMEOUT || OpenTherm::parity(response) || pairCount == MAX_PAIRS) return;
+	unsigned long i = 0;
+	while (i < pairCount && (pairs[i].request & 0x7FFFFFFF) != (request & 0x7FFFFFFF)) i++;
+	if (i == pairCount) distinct++;
+	pairs[pairCount++] = { request, response };
+}
+
+unsigned long expectedResponse(unsigned long request) {
+	unsigned long response = 0;
+	for (unsigned long i = 0; i < pairCount; i++) {
+		if ((pairs[i].request & 0x7FFFFFFF) == (request & 0x7FFFFFFF)) response = pairs[i].response;
+	}
+	return response;
+}
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	replay.handleRequest(request, status);
+}
+
+void background() {
+	slave.process();
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "../../vitovent300.log.txt";
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("cannot open %s\n", path);
+		return 1;
+	}
+	OpenThermLogParser parser(storePair);
+	int c;
+	while ((c = fgetc(file)) != EOF) parser.write(c);
+	parser.end();
+	fclose(file);
+	printf("%s: %lu pairs, %lu distinct requests, replay size %d\n", path, pairCount, distinct, OPENTHERM_REPLAY_SIZE);
+	expect(replay.getCount() == distinct, "every distinct request kept");
+
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	master.begin();
+	slave.begin(handleRequest);
+	unsigned long answered = 0, different = 0;
+	for (unsigned long i = 0; i < pairCount; i++) {
+		unsigned long response = master.sendRequest(pairs[i].request);
+		if (response == expectedResponse(pairs[i].request)) answered++;
+		else if (different++ < 5) printf("%08lX -> %08lX, recorded %08lX\n", pairs[i].request, response, expectedResponse(pairs[i].request));
+	}
+	printf("replayed %lu requests, %lu with the recorded response\n", pairCount, answered);
+	expect(different == 0, "recorded responses replayed");
+	master.sendRequest(OpenTherm::buildReadRequest<Tboiler>());
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::UNKNOWN_ID, "id not in the log: UNKNOWN-DATAID");
+	return failures > 0;
+}
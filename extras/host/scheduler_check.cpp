@@ -0,0 +1,127 @@
+/*
+scheduler_check.cpp - OpenThermScheduler with a write entry, reads and a TSP transfer on the simulated wire
+
+Value changes while a write is on the bus are coalesced into one write of the latest value, an id
+answered with UNKNOWN-DATAID is not asked again before the reprobe interval, the TSP table is read in
+idle slots and a write to a slave which stopped answering is retried with backoff while the reads go on.
+*/
+
+#include <Arduino.h>
+#include <OpenThermScheduler.h>
+
+#define TSP_SIZE 5
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+OpenThermScheduler scheduler(master);
+OpenThermTransfer tsp(TSP, TSPindexTSPvalue);
+
+bool answering = true;
+unsigned long pendingResponse;
+unsigned long pendingTimestamp;
+bool responsePending = false;
+unsigned long writes = 0, reads = 0, unknownReads = 0, tspReads = 0;
+uint16_t written = 0;
+int failures = 0;
+
+//boiler: TSet writes, Tboiler reads and a TSP table, other ids are unknown
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	OpenThermMessageID id = OpenTherm::getDataID(request);
+	unsigned int data = OpenTherm::getData(request);
+	if (id == TSet) {
+		writes++;
+		if (answering) written = data;
+		pendingResponse = OpenTherm::buildResponse(WRITE_ACK, id, data);
+	}
+	else if (id == Tboiler) {
+		reads++;
+		pendingResponse = OpenTherm::buildResponse(READ_ACK, id, 0x3C00);
+	}
+	else if (id == TSP) {
+		pendingResponse = OpenTherm::buildResponse(READ_ACK, id, TSP_SIZE << 8);
+	}
+	else if (id == TSPindexTSPvalue) {
+		tspReads++;
+		pendingResponse = OpenTherm::buildResponse(READ_ACK, id, (data & 0xFF00) | ((data >> 8) * 3));
+	}
+	else {
+		unknownReads++;
+		pendingResponse = OpenTherm::buildResponse(UNKNOWN_DATA_ID, id, data);
+	}
+	pendingTimestamp = millis();
+	responsePending = answering;
+}
+
+void background() {
+	slave.process();
+	if (responsePending && millis() - pendingTimestamp >= 40) {
+		responsePending = false;
+		slave.sendResponse(pendingResponse);
+	}
+}
+
+void run(unsigned long ms) {
+	unsigned long start = millis();
+	while (millis() - start < ms) {
+		scheduler.process();
+		delay(1);
+	}
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+int main() {
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	master.begin();
+	slave.begin(handleRequest);
+	int setpoint = scheduler.addWrite<TSet>(OpenThermF88::fromInt(40), 60000, 2);
+	scheduler.addRead<Tboiler>(1000, 1);
+	scheduler.addRead<Tdhw>(1000, 1);
+	scheduler.addTransfer(tsp);
+
+	//coalescing: the first write is on the wire, values changing meanwhile end in one write of the latest
+	run(5);
+	for (int value = 41; value <= 50; value++) {
+		scheduler.setValue<TSet>(setpoint, OpenThermF88::fromInt(value));
+		run(5);
+	}
+	run(2000);
+	printf("writes=%lu written=%04X\n", writes, written);
+	expect(writes == 2 && written == OpenThermF88::fromInt(50).toData(), "10 value changes during a write coalesced into one write");
+	expect(scheduler.isConfirmed(setpoint), "latest value confirmed");
+	scheduler.setValue<TSet>(setpoint, OpenThermF88::fromInt(50));
+	run(2000);
+	expect(writes == 2, "unchanged value not written again");
+
+	//TSP read once from start-up in idle slots, unknown id backs off to the reprobe interval
+	run(10000);
+	bool values = tsp.getSize() == TSP_SIZE;
+	for (byte i = 0; values && i < TSP_SIZE; i++) values = tsp.isValid(i) && tsp.getValue(i) == i * 3;
+	printf("tsp size=%u reads=%lu duration=%lums, Tdhw reads=%lu\n", tsp.getSize(), tspReads, tsp.getDuration(), unknownReads);
+	expect(!tsp.isRunning() && values && tspReads == TSP_SIZE, "TSP table read in idle slots, each entry once");
+	expect(unknownReads == 1, "UNKNOWN-DATAID id not asked again before reprobe");
+
+	//slave stops answering: retries after 1, 2 and 4s, then the refresh interval, reads are not starved
+	answering = false;
+	unsigned long writesBefore = writes, readsBefore = reads;
+	scheduler.setValue<TSet>(setpoint, OpenThermF88::fromInt(55));
+	run(30000);
+	printf("silent slave 30s: writes=%lu reads=%lu\n", writes - writesBefore, reads - readsBefore);
+	expect(writes - writesBefore == 4, "failed write sent once and retried 3 times");
+	expect(reads - readsBefore >= 15, "reads keep their slots");
+	expect(!scheduler.isConfirmed(setpoint), "unanswered value not confirmed");
+	run(40000);
+	expect(writes - writesBefore == 5, "then written every refresh interval");
+
+	answering = true;
+	scheduler.setValue<TSet>(setpoint, OpenThermF88::fromInt(56));
+	run(1000);
+	expect(scheduler.isConfirmed(setpoint) && written == OpenThermF88::fromInt(56).toData(), "new value written right away when the slave is back");
+	return failures > 0;
+}
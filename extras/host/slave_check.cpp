@@ -0,0 +1,84 @@
+/*
+slave_check.cpp - master against a slave mode instance with a register table on the simulated wire
+
+READ_DATA and WRITE_DATA against the table, an unknown data-id, access against the register
+direction and the response 20ms after the request stop bit.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+#define MASTER_OUT 5
+#define SLAVE_OUT 7
+
+OpenTherm master(4, MASTER_OUT);
+OpenTherm slave(6, SLAVE_OUT, true);
+OpenThermRegister registers[] = {
+	{ Tboiler,        DIR_READ,       0x3A80 },
+	{ TSet,           DIR_WRITE,      0x0000 },
+	{ MaxTSet,        DIR_READ_WRITE, 0x4B00 },
+};
+unsigned long requests = 0;
+unsigned long long masterLastEdge;
+unsigned long long slaveFirstEdge;
+int failures = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	(void)request;
+	if (status == OpenThermResponseStatus::SUCCESS) requests++;
+}
+
+void background() {
+	slave.process();
+}
+
+void trace(uint8_t pin, uint8_t level) {
+	(void)level;
+	if (pin == MASTER_OUT) {
+		masterLastEdge = hostMicros();
+		slaveFirstEdge = 0;
+	}
+	else if (pin == SLAVE_OUT && slaveFirstEdge == 0) slaveFirstEdge = hostMicros();
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+unsigned long send(unsigned long request, OpenThermResponseStatus expected) {
+	unsigned long response = master.sendRequest(request);
+	printf("%08lX -> %08lX status %d, turnaround %lluus\n", request, response, master.getLastResponseStatus(),
+		slaveFirstEdge - masterLastEdge);
+	expect(master.getLastResponseStatus() == expected, "response status");
+	return response;
+}
+
+int main() {
+	hostConnect(MASTER_OUT, 6);
+	hostConnect(SLAVE_OUT, 4);
+	hostSetBackground(background);
+	hostSetTrace(trace);
+	slave.setRegisters(registers, sizeof(registers) / sizeof(registers[0]));
+	master.begin();
+	slave.begin(handleRequest);
+
+	unsigned long response = send(OpenTherm::buildReadRequest<Tboiler>(), OpenThermResponseStatus::SUCCESS);
+	expect(OpenTherm::getMessageType(response) == READ_ACK && OpenTherm::getValue<Tboiler>(response).toFloat() == 58.5f, "READ_ACK with the register value");
+	unsigned long long turnaround = slaveFirstEdge - masterLastEdge;
+	expect(turnaround >= 20000 && turnaround <= 22000, "response 20..22ms after the last request edge");
+
+	response = send(OpenTherm::buildWriteRequest<TSet>(OpenThermF88::fromInt(55)), OpenThermResponseStatus::SUCCESS);
+	expect(OpenTherm::getMessageType(response) == WRITE_ACK && registers[1].value == 0x3700, "WRITE_ACK, register written");
+	send(OpenTherm::buildWriteRequest<MaxTSet>(OpenThermF88::fromInt(70)), OpenThermResponseStatus::SUCCESS);
+	response = send(OpenTherm::buildReadRequest<MaxTSet>(), OpenThermResponseStatus::SUCCESS);
+	expect(OpenTherm::getValue<MaxTSet>(response).toFloat() == 70.0f, "read back written value");
+
+	response = send(OpenTherm::buildReadRequest<Tret>(), OpenThermResponseStatus::UNKNOWN_ID);
+	expect(OpenTherm::getMessageType(response) == UNKNOWN_DATA_ID, "UNKNOWN-DATAID for an id not in the table");
+	send(OpenTherm::buildRequest(OpenThermRequestType::WRITE, Tboiler, 0x1000), OpenThermResponseStatus::DATA_REJECTED);
+	expect(registers[0].value == 0x3A80, "DATA-INVALID for a write to a read only register, value kept");
+	send(OpenTherm::buildRequest(OpenThermRequestType::READ, TSet, 0), OpenThermResponseStatus::DATA_REJECTED);
+	expect(requests == 7, "callback sees every request");
+	return failures > 0;
+}
@@ -0,0 +1,129 @@
+/*
+telemetry_check.cpp - OpenThermTelemetry records read back by OpenThermTelemetryReader
+
+The frames of a recorded log (vitovent300.log.txt by default) are written as binary records at
+varying times and decoded again: every record must come back with its timestamp, source, status
+and frame. Then the stream is damaged (stray sync bytes, noise between records, flipped bits):
+the reader has to drop exactly the damaged records and return all others.
+
+usage: telemetry_check [log file]
+*/
+
+#include <Arduino.h>
+#include <OpenThermLogParser.h>
+#include <OpenThermTelemetry.h>
+#include <time.h>
+
+#define MAX_RECORDS 4000
+
+OpenThermTelemetryRecord written[MAX_RECORDS];
+OpenThermTelemetryRecord decoded[MAX_RECORDS];
+unsigned long writtenCount = 0;
+unsigned long decodedCount = 0;
+int failures = 0;
+
+//binary stream of the telemetry
+class ByteBuffer : public Print
+{
+public:
+	uint8_t *data;
+	size_t size;
+	size_t length;
+	ByteBuffer(size_t size): data(new uint8_t[size]), size(size), length(0) {}
+	~ByteBuffer() { delete[] data; }
+	size_t write(uint8_t c) {
+		if (length == size) return 0;
+		data[length++] = c;
+		return 1;
+	}
+	using Print::write;
+};
+
+ByteBuffer stream(MAX_RECORDS * OPENTHERM_TELEMETRY_RECORD_SIZE);
+OpenThermTelemetry telemetry(stream);
+
+void writeFrame(unsigned long frame, char source, OpenThermResponseStatus status) {
+	if (writtenCount == MAX_RECORDS) return;
+	delay(random(1, 300));
+	telemetry.write(frame, source, status);
+	written[writtenCount++] = { millis(), frame, source, status };
+}
+
+void writePair(unsigned long request, unsigned long response, OpenThermResponseStatus status) {
+	writeFrame(request, 'T', OpenThermResponseStatus::SUCCESS);
+	if (status != OpenThermResponseStatus::TIMEOUT) writeFrame(response, 'B', status);
+}
+
+void collect(const OpenThermTelemetryRecord &record) {
+	if (decodedCount < MAX_RECORDS) decoded[decodedCount++] = record;
+}
+
+bool same(const OpenThermTelemetryRecord &a, const OpenThermTelemetryRecord &b) {
+	return a.timestamp == b.timestamp && a.frame == b.frame && a.source == b.source && a.status == b.status;
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+double seconds() {
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "../../vitovent300.log.txt";
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("cannot open %s\n", path);
+		return 1;
+	}
+	OpenThermLogParser parser(writePair);
+	int c;
+	while ((c = fgetc(file)) != EOF) parser.write(c);
+	parser.end();
+	fclose(file);
+	//sources and statuses the log has not: frames changed by a gateway, invalid response
+	writeFrame(0x10380000, 'R', OpenThermResponseStatus::SUCCESS);
+	writeFrame(0x50380000, 'A', OpenThermResponseStatus::SUCCESS);
+	writeFrame(0x40190000, 'B', OpenThermResponseStatus::INVALID);
+
+	OpenThermTelemetryReader reader(collect);
+	double start = seconds();
+	reader.write(stream.data, stream.length);
+	double elapsed = seconds() - start;
+	bool identical = decodedCount == writtenCount;
+	for (unsigned long i = 0; identical && i < writtenCount; i++) identical = same(decoded[i], written[i]);
+	printf("%s: %lu records, %u bytes, decoded %lu in %.0fus (%.1f MB/s)\n", path, writtenCount, (unsigned int)stream.length,
+		decodedCount, elapsed * 1e6, stream.length / 1e6 / elapsed);
+	expect(stream.length == writtenCount * OPENTHERM_TELEMETRY_RECORD_SIZE, "11 bytes per record");
+	expect(identical && reader.getErrorCount() == 0, "every record read back with timestamp, source, status and frame");
+
+	//damage: every 7th record has a flipped bit, every 5th is preceded by noise or a stray sync byte
+	ByteBuffer damaged(stream.length * 2);
+	bool intact[MAX_RECORDS];
+	unsigned long intactCount = 0;
+	for (unsigned long i = 0; i < writtenCount; i++) {
+		if (i % 5 == 0) damaged.write(i % 10 == 0 ? 0xA5 : 0x3C);
+		if (i % 15 == 0) damaged.write((const uint8_t *)"\x00\x11\xFF", 3);
+		const uint8_t *record = stream.data + i * OPENTHERM_TELEMETRY_RECORD_SIZE;
+		intact[i] = i % 7 != 3;
+		for (unsigned long b = 0; b < OPENTHERM_TELEMETRY_RECORD_SIZE; b++) {
+			damaged.write(!intact[i] && b == 1 + i % 10 ? record[b] ^ (1 << (i % 8)) : record[b]);
+		}
+		if (intact[i]) intactCount++;
+	}
+	decodedCount = 0;
+	OpenThermTelemetryReader damagedReader(collect);
+	damagedReader.write(damaged.data, damaged.length);
+	bool matches = decodedCount == intactCount;
+	for (unsigned long i = 0, d = 0; matches && i < writtenCount; i++) {
+		if (intact[i]) matches = same(decoded[d++], written[i]);
+	}
+	printf("damaged stream: %lu of %lu records intact, %lu decoded, %lu errors\n", intactCount, writtenCount, decodedCount,
+		damagedReader.getErrorCount());
+	expect(matches, "reader resynchronizes, returns exactly the intact records");
+	return failures > 0;
+}
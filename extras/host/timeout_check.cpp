@@ -0,0 +1,108 @@
+/*
+timeout_check.cpp - adaptive response timeout against a slave that answers late
+
+After fast responses the timeout drops to 50ms. A legal late response (150ms) must be reported
+as TIMEOUT early, then delivered when it arrives within the 800ms window and not be taken for the
+response to the next request. A response with another data-id must be rejected and a missing
+slave must not block the bus longer than the window.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+
+unsigned int latency = 20; //ms
+bool wrongId = false;
+unsigned long pendingResponse;
+unsigned long pendingTimestamp;
+unsigned int pendingDelay;
+bool responsePending = false;
+int failures = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	if (status != OpenThermResponseStatus::SUCCESS || responsePending) return; //busy with the late answer
+	OpenThermMessageID id = OpenTherm::getDataID(request);
+	if (wrongId) id = (OpenThermMessageID)(id + 1);
+	pendingResponse = OpenTherm::buildResponse(READ_ACK, id, id == Tboiler ? 0x3C80 : 0x2D00);
+	pendingTimestamp = millis();
+	pendingDelay = latency;
+	responsePending = true;
+}
+
+void background() {
+	slave.process();
+	if (responsePending && millis() - pendingTimestamp >= pendingDelay) {
+		responsePending = false;
+		slave.sendResponse(pendingResponse);
+	}
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+int main() {
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	master.begin();
+	slave.begin(handleRequest);
+
+	for (int i = 0; i < 8; i++) {
+		master.sendRequest(OpenTherm::buildGetBoilerTemperatureRequest());
+	}
+	printf("timeout after 8 responses at %ums: %lums\n", latency, master.getResponseTimeout() / 1000);
+	expect(master.getResponseTimeout() == 50000, "timeout adapted to 50ms");
+
+	latency = 150;
+	unsigned long response;
+	unsigned long long start = hostMicros();
+	master.sendRequestAync(OpenTherm::buildGetBoilerTemperatureRequest());
+	while (master.getLastResponseStatus() == OpenThermResponseStatus::NONE) {
+		master.process();
+		delay(1);
+	}
+	unsigned long detected = (unsigned long)(hostMicros() - start);
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::TIMEOUT, "150ms response reported as TIMEOUT");
+	printf("missing response reported after %lums (fixed timeout before: 1000ms)\n", detected / 1000);
+	while (!master.isReady()) {
+		master.process();
+		delay(1);
+	}
+	printf("bus ready again after %lums\n", (unsigned long)(hostMicros() - start) / 1000);
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS
+		&& master.getLastResponse() == OpenTherm::buildResponse(READ_ACK, Tboiler, 0x3C80), "late response delivered after the TIMEOUT");
+	expect(hostMicros() - start < 400000, "bus ready 100ms after the late response");
+	printf("timeout after the late response: %lums\n", master.getResponseTimeout() / 1000);
+	expect(master.getResponseTimeout() >= 300000, "timeout adapted to the late response");
+
+	response = master.sendRequest(OpenTherm::buildGetBoilerTemperatureRequest());
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS, "sendRequest with a 150ms slave succeeds");
+
+	latency = 20;
+	response = master.sendRequest(OpenTherm::buildReadRequest<Tret>());
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS, "next request succeeds");
+	expect(OpenTherm::getDataID(response) == Tret, "next request gets its own response");
+
+	wrongId = true;
+	response = master.sendRequest(OpenTherm::buildReadRequest<Tret>());
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::INVALID
+		&& master.getLastResponseError() == OpenThermResponseError::RESPONSE_ERROR_DATA_ID, "response with other data-id rejected");
+
+	wrongId = false;
+	master.sendRequest(OpenTherm::buildSetBoilerStatusRequest(true));
+	latency = 1000; //slave gone
+	for (int i = 0; i < 4; i++) {
+		start = hostMicros();
+		master.sendRequest(OpenTherm::buildGetBoilerTemperatureRequest());
+		unsigned long took = (unsigned long)(hostMicros() - start);
+		printf("missing slave: request took %lums\n", took / 1000);
+		expect(master.getLastResponseStatus() == OpenThermResponseStatus::TIMEOUT, "missing slave reported as TIMEOUT");
+		expect(took < 850000, "missing slave blocks the bus for the 800ms window only");
+		responsePending = false;
+	}
+	return failures > 0;
+}
@@ -0,0 +1,105 @@
+/*
+transmit_check.cpp - timer driven transmit against the blocking sendBit path
+
+The same request is sent once with delayMicroseconds and once clocked out by handleTimerAll
+from a simulated 500us timer interrupt. Both waveforms must have the same 68 half bits,
+sendRequestAync must return at once with the timer, and the master must hand over to
+RESPONSE_WAITING after the stop bit and receive the response of SimSlave.
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include "SimSlave.h"
+
+#define MASTER_OUT 5
+#define MAX_EDGES 128
+
+OpenTherm master(4, MASTER_OUT);
+OpenTherm slave(6, 7, true);
+SimSlave sim(slave);
+unsigned long long edgeTimes[MAX_EDGES];
+byte edgeLevels[MAX_EDGES];
+int edgeCount = 0;
+int failures = 0;
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	sim.handleRequest(request, status);
+}
+
+void background() {
+	sim.process();
+}
+
+void trace(uint8_t pin, uint8_t level) {
+	if (pin != MASTER_OUT || edgeCount == MAX_EDGES) return;
+	edgeTimes[edgeCount] = hostMicros();
+	edgeLevels[edgeCount++] = level;
+}
+
+void expect(bool condition, const char *message) {
+	printf("%s %s\n", condition ? "ok  " : "FAIL", message);
+	if (!condition) failures++;
+}
+
+//output level in the middle of each half bit, counted from the first edge, and one half bit after the frame
+void sample(byte *halfBits, int count) {
+	for (int i = 0; i < count; i++) {
+		unsigned long long t = edgeTimes[0] + i * 500ull + 250;
+		byte level = HIGH;
+		for (int e = 0; e < edgeCount && edgeTimes[e] <= t; e++) level = edgeLevels[e];
+		halfBits[i] = level;
+	}
+}
+
+//active (LOW) then idle is 1
+unsigned long decode(const byte *halfBits) {
+	unsigned long frame = 0;
+	for (int i = 2; i < 66; i += 2) frame = (frame << 1) | (halfBits[i] == LOW && halfBits[i + 1] == HIGH);
+	return frame;
+}
+
+int main() {
+	hostConnect(MASTER_OUT, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	hostSetTrace(trace);
+	master.begin();
+	slave.begin(handleRequest);
+	sim.setValue(Tboiler, 0x3A80);
+	const unsigned long request = OpenTherm::buildGetBoilerTemperatureRequest();
+	byte blocking[69], timer[69];
+
+	edgeCount = 0;
+	master.sendRequest(request);
+	sample(blocking, 69);
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS, "blocking transmit answered");
+
+	master.setTransmitTimer(true);
+	hostSetTimer(OpenTherm::handleTimerAll, 500);
+	edgeCount = 0;
+	unsigned long long start = hostMicros();
+	expect(master.sendRequestAync(request) && hostMicros() == start, "sendRequestAync returns at once");
+	bool readyWhileSending = false;
+	while (master.getLastResponseStatus() == OpenThermResponseStatus::NONE) {
+		if (hostMicros() - start < 34000 && master.isReady()) readyWhileSending = true;
+		master.process();
+		delay(1);
+	}
+	sample(timer, 69);
+	hostSetTimer(NULL, 0);
+
+	int halfBitEdges = 0;
+	for (int i = 1; i < edgeCount; i++) {
+		if ((edgeTimes[i] - edgeTimes[0]) % 500 == 0) halfBitEdges++;
+	}
+	printf("timer: %d edges, first %lluus after the call, last half bit ends %lluus after the first edge\n",
+		edgeCount, edgeTimes[0] - start, edgeTimes[edgeCount - 1] - edgeTimes[0] + 500);
+	expect(halfBitEdges == edgeCount - 1, "edges on the 500us half bit grid");
+	expect(memcmp(blocking, timer, 68) == 0, "68 half bits equal to the blocking path");
+	expect(timer[68] == HIGH, "line idle after the stop bit");
+	expect(decode(timer) == request, "waveform decodes to the request");
+	expect(!readyWhileSending, "bus busy while sending");
+	expect(master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS
+		&& OpenTherm::getDataID(master.getLastResponse()) == Tboiler, "RESPONSE_WAITING after the stop bit, response received");
+	return failures > 0;
+}
@@ -0,0 +1,79 @@
+/*
+wait_bench.cpp - sendRequest wait loop with waitForEvent against spinning on process() and yield()
+
+The spinning loop is the one sendRequest used before waitForEvent. Reports host CPU time,
+loop passes and virtual time until the bus is ready again per request.
+
+usage: wait_bench [requests] [latency ms]
+*/
+
+#include <Arduino.h>
+#include <OpenTherm.h>
+#include <time.h>
+#include "SimSlave.h"
+
+OpenTherm master(4, 5);
+OpenTherm slave(6, 7, true);
+SimSlave sim(slave);
+
+void handleRequest(unsigned long request, OpenThermResponseStatus status) {
+	sim.handleRequest(request, status);
+}
+
+void background() {
+	sim.process();
+}
+
+double seconds() {
+	timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+unsigned long spinRequest(unsigned long request, unsigned long &passes) {
+	if (!master.sendRequestAync(request)) return 0;
+	while (!master.isReady()) {
+		master.process();
+		yield();
+		passes++;
+	}
+	return master.getLastResponse();
+}
+
+int main(int argc, char **argv) {
+	unsigned long requests = argc > 1 ? atol(argv[1]) : 4;
+	sim.latency = argc > 2 ? atoi(argv[2]) : 40;
+	sim.jitter = 0;
+	hostConnect(5, 6);
+	hostConnect(7, 4);
+	hostSetBackground(background);
+	master.begin();
+	slave.begin(handleRequest);
+	const unsigned long request = OpenTherm::buildGetBoilerTemperatureRequest();
+	printf("requests=%lu latency=%ums\n", requests, sim.latency);
+
+	unsigned long passes = 0, ok = 0;
+	unsigned long long start = hostMicros();
+	double cpuStart = seconds();
+	for (unsigned long i = 0; i < requests; i++) {
+		spinRequest(request, passes);
+		if (master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS) ok++;
+	}
+	printf("spin:          ok=%lu host cpu=%.3fms passes=%lu %.2fms/request\n", ok, (seconds() - cpuStart) * 1e3, passes,
+		(hostMicros() - start) / 1e3 / requests);
+
+	master.resetStatistics();
+	ok = 0;
+	start = hostMicros();
+	cpuStart = seconds();
+	for (unsigned long i = 0; i < requests; i++) {
+		master.sendRequest(request);
+		if (master.getLastResponseStatus() == OpenThermResponseStatus::SUCCESS) ok++;
+	}
+	double cpu = seconds() - cpuStart;
+	OpenThermStatistics statistics;
+	master.getStatistics(statistics);
+	printf("waitForEvent:  ok=%lu host cpu=%.3fms passes=%lu (%lu busy, %lu idle) %.2fms/request\n", ok, cpu * 1e3,
+		statistics.busyWaits + statistics.idleWaits, statistics.busyWaits, statistics.idleWaits, (hostMicros() - start) / 1e3 / requests);
+	return 0;
+}
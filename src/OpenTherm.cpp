@@ -4,52 +4,194 @@ Copyright 2018, Ihor Melnyk
 */
 
 #include "OpenTherm.h"
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
 
-OpenTherm::OpenTherm(int inPin, int outPin):
+const byte OPENTHERM_CONFIG = 0; //only the name matters, see OpenTherm.h
+OpenTherm *OpenTherm::instances[OPENTHERM_MAX_BUSES];
+volatile bool OpenTherm::pendingEvent = false;
+
+char* OpenThermF88::toString(char* buffer) const
+{
+	int hundredths = toHundredths();
+	char* p = buffer;
+	if (hundredths < 0) {
+		*p++ = '-';
+		hundredths = -hundredths;
+	}
+	utoa(hundredths / 100, p, 10);
+	while (*p) p++;
+	*p++ = '.';
+	*p++ = '0' + (hundredths / 10) % 10;
+	*p++ = '0' + hundredths % 10;
+	*p = 0;
+	return buffer;
+}
+
+OpenTherm::OpenTherm(int inPin, int outPin, bool isSlave, const byte &):
 	inPin(inPin),
 	outPin(outPin),	
+	isSlave(isSlave),
 	status(OpenThermStatus::NOT_INITIALIZED),	
 	response(0),
 	responseStatus(OpenThermResponseStatus::NONE),
+	responseError(OpenThermResponseError::RESPONSE_ERROR_NONE),
 	responseTimestamp(0),
-	handleInterruptCallback(NULL),
-	processResponseCallback(NULL)
+	requestTimestamp(0),
+	frameTimestamp(0),
+	responseTimeout(OPENTHERM_FIXED_TIMEOUT ? OPENTHERM_FIXED_TIMEOUT : 800000),
+	latencyIndex(0),
+	request(0),
+	requestHalfBitIndex(0),
+	transmitTimer(false),
+	edgeHead(0),
+	edgeTail(0),
+	edgeTimestamp(0),
+	halfBitPeriod(500),
+	responseBitEdge(false),
+	registers(NULL),
+	registerCount(0),
+	handleInterruptCallback(NULL)
+#if OPENTHERM_CALLBACKS
+	, processResponseCallback(NULL)
+#endif
 {
+	for (byte i = 0; i < OPENTHERM_LATENCY_SAMPLES; i++) latencies[i] = 0;
+	resetSupported();
+#if OPENTHERM_STATISTICS
+	resetStatistics();
+#endif
 }
 
-void OpenTherm::begin(void(*handleInterruptCallback)(void), void(*processResponseCallback)(unsigned long, OpenThermResponseStatus))
+bool OpenTherm::begin(void(*handleInterruptCallback)(void))
 {
 	pinMode(inPin, INPUT);
-	pinMode(outPin, OUTPUT);
+	if (outPin >= 0) pinMode(outPin, OUTPUT);
+	//pins are resolved to port registers once, digitalRead/digitalWrite look them up on every call
+#if defined(__AVR__)
+	inRegister = portInputRegister(digitalPinToPort(inPin));
+	outRegister = portOutputRegister(digitalPinToPort(outPin < 0 ? inPin : outPin));
+	inMask = digitalPinToBitMask(inPin);
+	outMask = outPin < 0 ? 0 : digitalPinToBitMask(outPin);
+#elif defined(ESP8266)
+	inMask = inPin < 16 ? 1ul << inPin : 0;
+	outMask = outPin >= 0 && outPin < 16 ? 1ul << outPin : 0;
+#endif
+	registerInstance();
 	if (handleInterruptCallback != NULL) {
 		this->handleInterruptCallback = handleInterruptCallback;
 		attachInterrupt(digitalPinToInterrupt(inPin), handleInterruptCallback, CHANGE);		
 	}
+	if (isSlave) {
+		if (outPin >= 0) setIdleState();
+		listen();
+		return true;
+	}
 	activateBoiler();
 	status = OpenThermStatus::READY;
-	this->processResponseCallback = processResponseCallback;	
+	return true;
 }
 
-void OpenTherm::begin(void(*handleInterruptCallback)(void))
+#if OPENTHERM_CALLBACKS
+bool OpenTherm::begin(void(*handleInterruptCallback)(void), void(*processResponseCallback)(unsigned long, OpenThermResponseStatus))
 {
-	begin(handleInterruptCallback, NULL);	
+	this->processResponseCallback = processResponseCallback;
+	return begin(handleInterruptCallback);
 }
 
-bool OpenTherm::isReady()
+bool OpenTherm::begin(void(*processResponseCallback)(unsigned long, OpenThermResponseStatus))
 {
-	return status == OpenThermStatus::READY;
+	this->processResponseCallback = processResponseCallback;
+	return begin();
 }
+#endif
 
-int OpenTherm::readState() {
-	return digitalRead(inPin);
+//interrupt handler is generated by the library, up to OPENTHERM_MAX_BUSES instances,
+//false if all of them are taken: the bus is left uninitialized, pass an own handler instead
+bool OpenTherm::begin()
+{
+	int index = registerInstance();
+	if (index < 0) return false;
+	return begin(getInterruptTrampoline<OPENTHERM_MAX_BUSES - 1>(index));
 }
 
-void OpenTherm::setActiveState() {
-	digitalWrite(outPin, LOW);
+int OpenTherm::registerInstance()
+{
+	int index = -1;
+	for (byte i = 0; i < OPENTHERM_MAX_BUSES; i++) {
+		if (instances[i] == this) return i;
+		if (instances[i] == NULL && index < 0) index = i;
+	}
+	if (index >= 0) instances[index] = this;
+	return index;
+}
+
+void OpenTherm::unregisterInstance()
+{
+	for (byte i = 0; i < OPENTHERM_MAX_BUSES; i++) {
+		if (instances[i] == this) instances[i] = NULL;
+	}
+}
+
+//services every bus started with begin, lets one bus progress while another waits
+void OpenTherm::processAll()
+{
+	for (byte i = 0; i < OPENTHERM_MAX_BUSES; i++) {
+		if (instances[i] != NULL) instances[i]->process();
+	}
+}
+
+//call every 500us from one timer interrupt shared by all buses
+void OPENTHERM_ISR_ATTR OpenTherm::handleTimerAll()
+{
+	for (byte i = 0; i < OPENTHERM_MAX_BUSES; i++) {
+		if (instances[i] != NULL) instances[i]->handleTimer();
+	}
 }
 
-void OpenTherm::setIdleState() {
+bool OpenTherm::isReady()
+{
+	return status == OpenThermStatus::READY;
+}
+
+int OPENTHERM_ISR_ATTR OpenTherm::readState() {
+#if defined(__AVR__)
+	return (*inRegister & inMask) ? HIGH : LOW;
+#elif defined(ESP8266)
+	if (inMask == 0) return digitalRead(inPin);
+	return (GPI & inMask) ? HIGH : LOW;
+#else
+	return digitalRead(inPin);
+#endif
+}
+
+void OPENTHERM_ISR_ATTR OpenTherm::setActiveState() {
+#if defined(__AVR__)
+	uint8_t oldSREG = SREG;
+	cli();
+	*outRegister &= ~outMask;
+	SREG = oldSREG;
+#elif defined(ESP8266)
+	if (outMask == 0) digitalWrite(outPin, LOW);
+	else GPOC = outMask;
+#else
+	digitalWrite(outPin, LOW);
+#endif
+}
+
+void OPENTHERM_ISR_ATTR OpenTherm::setIdleState() {
+#if defined(__AVR__)
+	uint8_t oldSREG = SREG;
+	cli();
+	*outRegister |= outMask;
+	SREG = oldSREG;
+#elif defined(ESP8266)
+	if (outMask == 0) digitalWrite(outPin, HIGH);
+	else GPOS = outMask;
+#else
 	digitalWrite(outPin, HIGH);
+#endif
 }
 
 void OpenTherm::activateBoiler() {
@@ -71,76 +213,341 @@ bool OpenTherm::sendRequestAync(unsigned long request)
 	const bool ready = isReady();
 	interrupts();
 
-	if (!ready)
+	if (!ready || isSlave || outPin < 0)
 	  return false;
 
-	status = OpenThermStatus::REQUEST_SENDING;
 	response = 0;
 	responseStatus = OpenThermResponseStatus::NONE;
+	responseError = OpenThermResponseError::RESPONSE_ERROR_NONE;
+	sendFrame(request);
+	return true;
+}
+
+//ends in RESPONSE_WAITING, master waits for the response, slave for the next request
+void OpenTherm::sendFrame(unsigned long frame)
+{
+#if OPENTHERM_STATISTICS
+	statistics.framesSent++;
+	recordBusy(34000);
+#endif
+	responseTimestamp = micros();
+	edgeTail = edgeHead;
+	this->request = frame; //master checks the response data-id against it
+
+	if (transmitTimer) {
+		//frame is clocked out by handleTimer
+		requestHalfBitIndex = 0;
+		status = OpenThermStatus::REQUEST_SENDING;
+		return;
+	}
 
+	status = OpenThermStatus::REQUEST_SENDING;
 	sendBit(HIGH); //start bit
 	for (int i = 31; i >= 0; i--) {
-		sendBit(bitRead(request, i));
+		sendBit(bitRead(frame, i));
 	}
 	sendBit(HIGH); //stop bit  
 	setIdleState();
 
+	requestTimestamp = micros();
+	responseTimestamp = requestTimestamp;
 	status = OpenThermStatus::RESPONSE_WAITING;
-	responseTimestamp = micros();	
+}
+
+//slave mode, response is sent 20ms after the request (earliest allowed by the spec)
+//can be called from processResponseCallback to replace the answer from the register table
+bool OpenTherm::sendResponse(unsigned long response)
+{
+	noInterrupts();
+	const OpenThermStatus st = status;
+	interrupts();
+	if (!isSlave || outPin < 0 || (st != OpenThermStatus::RESPONSE_WAITING && st != OpenThermStatus::DELAY)) return false;
+
+	request = response;
+	status = OpenThermStatus::DELAY;
 	return true;
 }
 
+void OpenTherm::listen()
+{
+	noInterrupts();
+	edgeTail = edgeHead;
+	response = 0;
+	responseError = OpenThermResponseError::RESPONSE_ERROR_NONE;
+	status = OpenThermStatus::RESPONSE_WAITING;
+	interrupts();
+}
+
+void OpenTherm::setRegisters(OpenThermRegister *registers, byte count)
+{
+	this->registers = registers;
+	registerCount = count;
+}
+
+OpenThermRegister *OpenTherm::findRegister(OpenThermMessageID id)
+{
+	for (byte i = 0; i < registerCount; i++) {
+		if (registers[i].id == id) return &registers[i];
+	}
+	return NULL;
+}
+
+//unknown ids are answered with UNKNOWN-DATAID, access against the register direction with DATA-INVALID
+unsigned long OpenTherm::getRegisterResponse(unsigned long request)
+{
+	OpenThermMessageType type = getMessageType(request);
+	OpenThermMessageID id = getDataID(request);
+	unsigned int data = getData(request);
+	OpenThermRegister *reg = findRegister(id);
+	if (reg == NULL) {
+		return buildResponse(OpenThermMessageType::UNKNOWN_DATA_ID, id, data);
+	}
+	if (type == OpenThermMessageType::READ_DATA && reg->direction != OpenThermDirection::DIR_WRITE) {
+		return buildResponse(OpenThermMessageType::READ_ACK, id, reg->value);
+	}
+	if (type == OpenThermMessageType::WRITE_DATA && reg->direction != OpenThermDirection::DIR_READ) {
+		reg->value = data;
+		return buildResponse(OpenThermMessageType::WRITE_ACK, id, data);
+	}
+	return buildResponse(OpenThermMessageType::DATA_INVALID, id, data);
+}
+
 unsigned long OpenTherm::sendRequest(unsigned long request)
 {	
 	if (!sendRequestAync(request)) return 0;
 	while (!isReady()) {
 		process();
-		yield();
+		for (byte i = 0; i < OPENTHERM_MAX_BUSES; i++) { //keep other buses going while waiting
+			if (instances[i] != NULL && instances[i] != this) instances[i]->process();
+		}
+#if OPENTHERM_STATISTICS
+		if (waitForEvent()) statistics.idleWaits++; else statistics.busyWaits++;
+#else
+		waitForEvent();
+#endif
 	}	
 	return response;
 }
 
+//sleeps until the next interrupt: edges and end of transmit wake up immediately,
+//timeouts and delay are noticed on the next millis tick (AVR) or after 1ms
+bool OpenTherm::waitForEvent()
+{
+	noInterrupts();
+	if (pendingEvent) {
+		pendingEvent = false;
+		interrupts();
+		return false;
+	}
+#if defined(__AVR__)
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	interrupts(); //sleep instruction runs before any pending interrupt
+	sleep_cpu();
+	sleep_disable();
+#else
+	interrupts();
+	delay(1); //lets the idle task / light sleep run on ESP8266 and ESP32
+#endif
+	pendingEvent = false; //caller processes right after wake up
+	return true;
+}
+
+void OpenTherm::setTransmitTimer(bool enabled)
+{
+	transmitTimer = enabled;
+}
+
+//call every 500us from a timer interrupt when transmit timer is enabled
+//start bit, 32 data bits and stop bit are sent as 68 manchester half-bits
+void OPENTHERM_ISR_ATTR OpenTherm::handleTimer()
+{
+	if (status != OpenThermStatus::REQUEST_SENDING || !transmitTimer) return;
+
+	if (requestHalfBitIndex < 68) {
+		byte bitIndex = requestHalfBitIndex >> 1; //0 - start bit, 1..32 - data bits, 33 - stop bit
+		bool high = (bitIndex == 0 || bitIndex == 33) ? true : bitRead(request, 32 - bitIndex);
+		bool firstHalf = !(requestHalfBitIndex & 1);
+		if (high == firstHalf) setActiveState(); else setIdleState();
+		requestHalfBitIndex++;
+	}
+	else {
+		setIdleState();
+		requestTimestamp = micros();
+		responseTimestamp = requestTimestamp;
+		status = OpenThermStatus::RESPONSE_WAITING;
+		pendingEvent = true;
+	}
+}
+
+unsigned long OpenTherm::getLastResponse()
+{
+	return response;
+}
+
 OpenThermResponseStatus OpenTherm::getLastResponseStatus()
 {
 	return responseStatus;
 }
 
-void OpenTherm::handleInterrupt()
-{	
-	if (isReady()) return;	
+OpenThermResponseError OpenTherm::getLastResponseError()
+{
+	return responseError;
+}
 
-	unsigned long newTs = micros();
-	if (status == OpenThermStatus::RESPONSE_WAITING) {
-		if (readState() == HIGH) {
-			status = OpenThermStatus::RESPONSE_START_BIT;
-			responseTimestamp = newTs;
-		}
-		else {
-			status = OpenThermStatus::RESPONSE_INVALID;
-			responseTimestamp = newTs;
-		}
+//micros
+unsigned long OpenTherm::getLastFrameTimestamp()
+{
+	return frameTimestamp;
+}
+
+//false after UNKNOWN-DATAID response until the id is answered again
+bool OpenTherm::isSupported(OpenThermMessageID id)
+{
+	return id >= 128 || !(unsupportedIds[id >> 3] & (1 << (id & 7)));
+}
+
+void OpenTherm::setSupported(OpenThermMessageID id, bool supported)
+{
+	if (id >= 128) return;
+	if (supported) unsupportedIds[id >> 3] &= ~(1 << (id & 7));
+	else unsupportedIds[id >> 3] |= 1 << (id & 7);
+}
+
+void OpenTherm::resetSupported()
+{
+	memset(unsupportedIds, 0, sizeof(unsupportedIds));
+}
+
+//us, adapts to measured slave latency
+unsigned long OpenTherm::getResponseTimeout()
+{
+	return responseTimeout;
+}
+
+//timeout is twice the largest of the last latencies plus 10ms, within 50..800ms (spec: slave responds in 20..800ms),
+//after a timeout it doubles until the next response arrives
+void OpenTherm::updateResponseTimeout(bool timedOut)
+{
+#if OPENTHERM_FIXED_TIMEOUT
+	return;
+#endif
+	if (timedOut) {
+		responseTimeout = responseTimeout < 400000 ? responseTimeout * 2 : 800000;
+		return;
+	}
+	unsigned long latency = responseTimestamp - requestTimestamp - 67ul * halfBitPeriod; //stop bit edge is 33.5 bits after start
+	latencies[latencyIndex] = latency < 800000 ? latency / 1000 : 800;
+	latencyIndex = (latencyIndex + 1) % OPENTHERM_LATENCY_SAMPLES;
+	unsigned int maxLatency = 0;
+	for (byte i = 0; i < OPENTHERM_LATENCY_SAMPLES; i++) {
+		if (latencies[i] > maxLatency) maxLatency = latencies[i];
 	}
-	else if (status == OpenThermStatus::RESPONSE_START_BIT) {
-		if ((newTs - responseTimestamp < 750) && readState() == LOW) {
-			status = OpenThermStatus::RESPONSE_RECEIVING;
-			responseTimestamp = newTs;
-			responseBitIndex = 0;
+	responseTimeout = (2ul * maxLatency + 10) * 1000;
+	if (responseTimeout < 50000) responseTimeout = 50000;
+	if (responseTimeout > 800000) responseTimeout = 800000;
+}
+
+//only records edge timestamp and line level, edges are decoded in process
+void OPENTHERM_ISR_ATTR OpenTherm::handleInterrupt()
+{
+	OpenThermStatus st = status;
+	if (st == OpenThermStatus::DELAY) { //delay counts from the last edge on the line
+		responseTimestamp = micros();
+		return;
+	}
+	if (st != OpenThermStatus::RESPONSE_WAITING && st != OpenThermStatus::RESPONSE_START_BIT && st != OpenThermStatus::RESPONSE_RECEIVING) return;
+
+	byte head = edgeHead;
+	if ((byte)(head - edgeTail) >= OPENTHERM_EDGE_BUFFER_SIZE) return; //overflow, frame will be invalid
+	unsigned long newTs = micros();
+	edges[head & (OPENTHERM_EDGE_BUFFER_SIZE - 1)] = ((uint16_t)newTs & 0xFFFE) | readState();
+	edgeHead = head + 1;
+	responseTimestamp = newTs;
+	pendingEvent = true;
+#if OPENTHERM_STATISTICS
+	unsigned int duration = micros() - newTs;
+	if (duration > statistics.maxInterruptMicros) statistics.maxInterruptMicros = duration;
+#endif
+}
+
+void OpenTherm::setResponseInvalid(OpenThermResponseError error)
+{
+	responseError = error;
+	status = OpenThermStatus::RESPONSE_INVALID;
+}
+
+//bit clock is locked to the start bit and follows slave drift,
+//edges between bits are expected after 0.5..1.5 and mid-bit edges after 1.5..2.5 half bit periods
+void OpenTherm::decodeEdges()
+{
+	while (edgeTail != edgeHead) {
+		uint16_t edge = edges[edgeTail & (OPENTHERM_EDGE_BUFFER_SIZE - 1)];
+		edgeTail++;
+		uint16_t ts = edge & 0xFFFE;
+		int state = edge & 1;
+		uint16_t elapsed = ts - edgeTimestamp;
+
+		if (status == OpenThermStatus::RESPONSE_WAITING) {
+			if (state == HIGH) {
+				status = OpenThermStatus::RESPONSE_START_BIT;
+				edgeTimestamp = ts;
+			}
+			else {
+				setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_MANCHESTER);
+				return;
+			}
 		}
-		else {
-			status = OpenThermStatus::RESPONSE_INVALID;
-			responseTimestamp = newTs;
+		else if (status == OpenThermStatus::RESPONSE_START_BIT) {
+			//second half of start bit gives bit period of the slave
+			if (elapsed > 250 && elapsed < 750 && state == LOW) {
+				status = OpenThermStatus::RESPONSE_RECEIVING;
+				halfBitPeriod = elapsed;
+				edgeTimestamp = ts;
+				responseBitIndex = 0;
+				responseBitEdge = false;
+			}
+			else {
+				setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_MANCHESTER);
+				return;
+			}
 		}
-	}
-	else if (status == OpenThermStatus::RESPONSE_RECEIVING) {
-		if ((newTs - responseTimestamp) > 750) {
+		else if (status == OpenThermStatus::RESPONSE_RECEIVING) {
+			unsigned int half = halfBitPeriod;
+			if (elapsed < (half >> 1) || elapsed > (half << 1) + (half >> 1)) { //glitch or lost edge
+				setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_MANCHESTER);
+				return;
+			}
+			if (elapsed <= half + (half >> 1)) { //edge between bits
+				if (responseBitEdge) {
+					setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_MANCHESTER);
+					return;
+				}
+				responseBitEdge = true;
+				continue;
+			}
+
+			bool bit = !state;
+			if (responseBitIndex == 32 && !bit) {
+				setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_STOP_BIT);
+				return;
+			}
+			//equal neighbour bits are separated by an edge, different ones are not
+			bool previousBit = responseBitIndex == 0 ? true : (response & 1);
+			if ((bit == previousBit) != responseBitEdge) {
+				setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_MANCHESTER);
+				return;
+			}
+			halfBitPeriod = (3 * half + (elapsed >> 1)) >> 2;
+			edgeTimestamp = ts;
+			responseBitEdge = false;
 			if (responseBitIndex < 32) {
-				response = (response << 1) | !readState();
-				responseTimestamp = newTs;
+				response = (response << 1) | bit;
 				responseBitIndex++;
 			}
 			else { //stop bit
 				status = OpenThermStatus::RESPONSE_READY;
-				responseTimestamp = newTs;
+				return;
 			}
 		}
 	}
@@ -148,32 +555,109 @@ void OpenTherm::handleInterrupt()
 
 void OpenTherm::process()
 {
-	noInterrupts();
 	OpenThermStatus st = status;
+	if (st == OpenThermStatus::RESPONSE_WAITING || st == OpenThermStatus::RESPONSE_START_BIT || st == OpenThermStatus::RESPONSE_RECEIVING) {
+		decodeEdges();
+	}
+
+	noInterrupts();
+	st = status;
 	unsigned long ts = responseTimestamp;
 	interrupts();	
 
 	if (st == OpenThermStatus::READY) return;
+	if (isSlave) {
+		processRequest(st, ts);
+		return;
+	}
 	unsigned long newTs = micros();
-	if (st != OpenThermStatus::NOT_INITIALIZED && (newTs - ts) > 1000000) {
+	//spec: slave responds within 800ms, the line stays reserved for that window
+	const unsigned long window = OPENTHERM_FIXED_TIMEOUT > 800000 ? OPENTHERM_FIXED_TIMEOUT : 800000;
+	//early timeout has been reported, a response still arriving in the window replaces it
+	bool late = responseStatus == OpenThermResponseStatus::TIMEOUT;
+	if (st == OpenThermStatus::RESPONSE_WAITING && !late && responseTimeout < window && (newTs - ts) > responseTimeout) {
+		updateResponseTimeout(true);
 		responseStatus = OpenThermResponseStatus::TIMEOUT;
-		if (processResponseCallback != NULL) {
-			processResponseCallback(response, responseStatus);
+		notify(response);
+	}
+	else if (st != OpenThermStatus::NOT_INITIALIZED && st != OpenThermStatus::DELAY
+		&& (newTs - ts) > (st == OpenThermStatus::RESPONSE_WAITING ? window : 1000000)) {
+		if (st == OpenThermStatus::RESPONSE_WAITING && !late) {
+			updateResponseTimeout(true);
+		}
+#if OPENTHERM_STATISTICS
+		statistics.timeout++;
+#endif
+		if (!late) {
+			responseStatus = OpenThermResponseStatus::TIMEOUT;
+			notify(response);
 		}
-		status = OpenThermStatus::READY;		
+		status = OpenThermStatus::DELAY;
 	}	
+	else if ((st == OpenThermStatus::RESPONSE_START_BIT || st == OpenThermStatus::RESPONSE_RECEIVING) && (newTs - ts) > 6ul * halfBitPeriod) {
+		//no edge for 3 bit periods, frame is truncated
+		responseError = OpenThermResponseError::RESPONSE_ERROR_BIT_COUNT;
+		responseStatus = OpenThermResponseStatus::INVALID;
+#if OPENTHERM_STATISTICS
+		statistics.invalid[responseError]++;
+#endif
+		notify(response);
+		status = OpenThermStatus::DELAY;
+	}
 	else if (st == OpenThermStatus::RESPONSE_INVALID) {		
 		responseStatus = OpenThermResponseStatus::INVALID;
-		if (processResponseCallback != NULL) {
-			processResponseCallback(response, responseStatus);
-		}
+#if OPENTHERM_STATISTICS
+		statistics.invalid[responseError]++;
+#endif
+		notify(response);
 		status = OpenThermStatus::DELAY;		
 	}
 	else if (st == OpenThermStatus::RESPONSE_READY) {		
-		responseStatus = isValidResponse(response) ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
-		if (processResponseCallback != NULL) {
-			processResponseCallback(response, responseStatus);
+		frameTimestamp = ts;
+		OpenThermMessageType type = getMessageType(response);
+		if (parity(response)) {
+			responseError = OpenThermResponseError::RESPONSE_ERROR_PARITY;
+			responseStatus = OpenThermResponseStatus::INVALID;
+		}
+		else if (type == OpenThermMessageType::UNKNOWN_DATA_ID) {
+			responseStatus = OpenThermResponseStatus::UNKNOWN_ID;
+		}
+		else if (type == OpenThermMessageType::DATA_INVALID) {
+			responseStatus = OpenThermResponseStatus::DATA_REJECTED;
+		}
+		else if (!isValidResponse(response)) {
+			responseError = OpenThermResponseError::RESPONSE_ERROR_MSG_TYPE;
+			responseStatus = OpenThermResponseStatus::INVALID;
+		}
+		else {
+			responseStatus = OpenThermResponseStatus::SUCCESS;
+		}
+		if (responseError == OpenThermResponseError::RESPONSE_ERROR_NONE && getDataID(response) != getDataID(request)) {
+			//e.g. late answer to an earlier request
+			responseError = OpenThermResponseError::RESPONSE_ERROR_DATA_ID;
+			responseStatus = OpenThermResponseStatus::INVALID;
+		}
+		if (responseError == OpenThermResponseError::RESPONSE_ERROR_NONE) {
+			updateResponseTimeout(false);
+			setSupported(getDataID(response), responseStatus != OpenThermResponseStatus::UNKNOWN_ID);
+		}
+#if OPENTHERM_STATISTICS
+		recordBusy(68ul * halfBitPeriod);
+		if (responseStatus == OpenThermResponseStatus::SUCCESS) {
+			statistics.success++;
+			recordLatency(getDataID(response), ts - requestTimestamp);
+		}
+		else if (responseStatus == OpenThermResponseStatus::UNKNOWN_ID) {
+			statistics.unknownDataId++;
+		}
+		else if (responseStatus == OpenThermResponseStatus::DATA_REJECTED) {
+			statistics.dataInvalid++;
 		}
+		else {
+			statistics.invalid[responseError]++;
+		}
+#endif
+		notify(response);
 		status = OpenThermStatus::DELAY;		
 	}
 	else if (st == OpenThermStatus::DELAY) {
@@ -183,56 +667,128 @@ void OpenTherm::process()
 	}	
 }
 
-bool OpenTherm::parity(unsigned long frame) //odd parity
+//slave mode, request is decoded into response like a response in master mode
+//ts: responseTimestamp read together with the status while interrupts were off
+void OpenTherm::processRequest(OpenThermStatus st, unsigned long ts)
 {
-	byte p = 0;
-	while (frame > 0)
-	{
-		if (frame & 1) p++;
-		frame = frame >> 1;
+	unsigned long newTs = micros();
+	if ((st == OpenThermStatus::RESPONSE_START_BIT || st == OpenThermStatus::RESPONSE_RECEIVING) && (newTs - ts) > 6ul * halfBitPeriod) {
+		setResponseInvalid(OpenThermResponseError::RESPONSE_ERROR_BIT_COUNT);
+		st = OpenThermStatus::RESPONSE_INVALID;
 	}
-	return (p & 1);
-}
 
-unsigned long OpenTherm::buildRequest(OpenThermRequestType type, OpenThermMessageID id, unsigned int data)
-{
-	unsigned long request = data;
-	if (type == OpenThermRequestType::WRITE) {
-		request |= 1ul << 28;
+	if (st == OpenThermStatus::RESPONSE_READY || st == OpenThermStatus::RESPONSE_INVALID) {
+		unsigned long request = response;
+		frameTimestamp = ts;
+		if (st == OpenThermStatus::RESPONSE_READY && (outPin < 0 ? parity(request) : !isValidRequest(request))) {
+			responseError = parity(request) ? OpenThermResponseError::RESPONSE_ERROR_PARITY : OpenThermResponseError::RESPONSE_ERROR_MSG_TYPE;
+		}
+		responseStatus = responseError == OpenThermResponseError::RESPONSE_ERROR_NONE ? OpenThermResponseStatus::SUCCESS : OpenThermResponseStatus::INVALID;
+#if OPENTHERM_STATISTICS
+		if (responseStatus == OpenThermResponseStatus::SUCCESS) statistics.success++;
+		else statistics.invalid[responseError]++;
+#endif
+		listen();
+		if (responseStatus == OpenThermResponseStatus::SUCCESS && registers != NULL) {
+			sendResponse(getRegisterResponse(request));
+		}
+		notify(request);
+	}
+	else if (st == OpenThermStatus::DELAY) {
+		if ((newTs - ts) > 20000) {
+			sendFrame(request);
+		}
 	}
-	request |= ((unsigned long)id) << 16;
-	if (parity(request)) request |= (1ul << 31);
-	return request;
 }
 
-bool OpenTherm::isValidResponse(unsigned long response)
+#if OPENTHERM_STATISTICS
+void OpenTherm::recordBusy(unsigned long duration)
 {
-	if (parity(response)) return false;
-	byte msgType = (response << 1) >> 29;
-	return msgType == 4 || msgType == 5; //4 - read, 5 - write
+	busyMicros += duration;
+	statistics.busyMillis += busyMicros / 1000;
+	busyMicros %= 1000;
 }
 
-void OpenTherm::end() {
-	if (this->handleInterruptCallback != NULL) {		
-		detachInterrupt(digitalPinToInterrupt(inPin));
+void OpenTherm::recordLatency(byte id, unsigned long latency)
+{
+	static const uint16_t limits[OPENTHERM_LATENCY_BUCKETS - 1] = { 50, 100, 150, 200, 300, 400, 600 };
+	OpenThermLatencyHistogram *histogram = NULL;
+	for (byte i = 0; i < OPENTHERM_STATISTICS_IDS && histogram == NULL; i++) {
+		if (statistics.latency[i].id == id || statistics.latency[i].id == 0xFF) histogram = &statistics.latency[i];
 	}
+	if (histogram == NULL) return; //all histograms taken by other ids
+	histogram->id = id;
+	byte bucket = 0;
+	latency /= 1000;
+	while (bucket < OPENTHERM_LATENCY_BUCKETS - 1 && latency >= limits[bucket]) bucket++;
+	if (histogram->buckets[bucket] < 0xFFFF) histogram->buckets[bucket]++;
 }
 
-//building requests
+void OpenTherm::getStatistics(OpenThermStatistics &snapshot)
+{
+	noInterrupts();
+	snapshot = statistics;
+	interrupts();
+	snapshot.elapsedMillis = millis() - statisticsTimestamp;
+}
 
-unsigned long OpenTherm::buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater, bool enableCooling, bool enableOutsideTemperatureCompensation, bool enableCentralHeating2) {
-	unsigned int data = enableCentralHeating | (enableHotWater << 1) | (enableCooling << 2) | (enableOutsideTemperatureCompensation << 3) | (enableCentralHeating2 << 4);
-	data <<= 8;	
-	return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::Status, data);
+void OpenTherm::resetStatistics()
+{
+	noInterrupts();
+	memset(&statistics, 0, sizeof(statistics));
+	interrupts();
+	for (byte i = 0; i < OPENTHERM_STATISTICS_IDS; i++) statistics.latency[i].id = 0xFF;
+	busyMicros = 0;
+	statisticsTimestamp = millis();
 }
 
-unsigned long OpenTherm::buildSetBoilerTemperatureRequest(float temperature) {
-	unsigned int data = temperatureToData(temperature);
-	return buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::TSet, data);
+//sent=10 ok=8 timeout=1 unkn=1 dinv=0 invalid=0/0/0/0/0/0 isr=12us busy=41%
+//id=25 8/2/0/0/0/0/0/0
+void OpenTherm::printStatistics(Print &out)
+{
+	OpenThermStatistics snapshot;
+	getStatistics(snapshot);
+	out.print(F("sent="));
+	out.print(snapshot.framesSent);
+	out.print(F(" ok="));
+	out.print(snapshot.success);
+	out.print(F(" timeout="));
+	out.print(snapshot.timeout);
+	out.print(F(" unkn="));
+	out.print(snapshot.unknownDataId);
+	out.print(F(" dinv="));
+	out.print(snapshot.dataInvalid);
+	out.print(F(" invalid="));
+	for (byte i = 0; i <= RESPONSE_ERROR_DATA_ID; i++) {
+		if (i > 0) out.print('/');
+		out.print(snapshot.invalid[i]);
+	}
+	out.print(F(" isr="));
+	out.print(snapshot.maxInterruptMicros);
+	out.print(F("us busy="));
+	out.print(snapshot.elapsedMillis > 0 ? snapshot.busyMillis * 100 / snapshot.elapsedMillis : 0);
+	out.print(F("% wait="));
+	out.print(snapshot.busyWaits);
+	out.print('/');
+	out.println(snapshot.idleWaits);
+	for (byte i = 0; i < OPENTHERM_STATISTICS_IDS; i++) {
+		if (snapshot.latency[i].id == 0xFF) continue;
+		out.print(F("id="));
+		out.print(snapshot.latency[i].id);
+		for (byte j = 0; j < OPENTHERM_LATENCY_BUCKETS; j++) {
+			out.print(j == 0 ? ' ' : '/');
+			out.print(snapshot.latency[i].buckets[j]);
+		}
+		out.println();
+	}
 }
+#endif
 
-unsigned long OpenTherm::buildGetBoilerTemperatureRequest() {
-	return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::Tboiler, 0);
+void OpenTherm::end() {
+	if (this->handleInterruptCallback != NULL) {		
+		detachInterrupt(digitalPinToInterrupt(inPin));
+	}
+	unregisterInstance();
 }
 
 //parsing responses
@@ -261,17 +817,14 @@ bool OpenTherm::isDiagnostic(unsigned long response) {
 }
 
 float OpenTherm::getTemperature(unsigned long response) {
-	float temperature = isValidResponse(response) ? (response & 0xFFFF) / 256.0 : 0;
-	return temperature;
+	return getFixedTemperature(response).toFloat();
 }
 
-unsigned int OpenTherm::temperatureToData(float temperature) {
-	if (temperature < 0) temperature = 0;
-	if (temperature > 100) temperature = 100;
-	unsigned int data = (unsigned int)(temperature * 256);
-	return data;
+OpenThermF88 OpenTherm::getFixedTemperature(unsigned long response) {
+	return isValidResponse(response) ? OpenThermF88::fromData(getData(response)) : OpenThermF88();
 }
 
+#if OPENTHERM_BOILER
 //basic requests
 
 unsigned long OpenTherm::setBoilerStatus(bool enableCentralHeating, bool enableHotWater, bool enableCooling, bool enableOutsideTemperatureCompensation, bool enableCentralHeating2) {	
@@ -283,40 +836,23 @@ bool OpenTherm::setBoilerTemperature(float temperature) {
 	return isValidResponse(response);
 }
 
+bool OpenTherm::setBoilerTemperature(OpenThermF88 temperature) {
+	unsigned long response = sendRequest(buildSetBoilerTemperatureRequest(temperature));
+	return isValidResponse(response);
+}
+
 float OpenTherm::getBoilerTemperature() {
 	unsigned long response = sendRequest(buildGetBoilerTemperatureRequest());
 	return getTemperature(response);
 }
 
-
-//building requests for home ventilation system
-
-unsigned long OpenTherm::buildSetVentilationMasterProductVersion(unsigned int hi, unsigned int lo) {
-    // T:OTMessage[WRITE_DATA,id:126,hi:18,lo:2,Master product version]:0
-    unsigned int data = (hi<<8) | lo;
-    unsigned long request = buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::MasterVersion, data);
-    return sendRequest(request);
-}
-
-unsigned long OpenTherm::buildGetVentilationTSPSetting(unsigned int index) {
-    // T:OTMessage[READ_DATA,id:89,hi:18,lo:0,TSP setting V/H]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::TspSettingsVH, index);
-}
-
-unsigned long OpenTherm::buildSetVentilationMasterConfiguration(unsigned int hi, unsigned int lo) {
-    // T:OTMessage[WRITE_DATA,id:2,hi:0,lo:18,Master configuration]:0
-    unsigned int data = (hi<<8) | lo;
-    unsigned long request = buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::MConfigMMemberIDcode, data);
-    return sendRequest(request);
-}
-
-unsigned long OpenTherm::buildSetVentilationControlSetpoint(unsigned int level) {
-    // T:OTMessage[WRITE_DATA,id:71,hi:0,lo:2,Control setpoint V/H]:0
-    unsigned long request = buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::ControlSetpointVH, level);
-    return sendRequest(request);
+OpenThermF88 OpenTherm::getFixedBoilerTemperature() {
+	unsigned long response = sendRequest(buildGetBoilerTemperatureRequest());
+	return getFixedTemperature(response);
 }
+#endif
 
-
+#if OPENTHERM_VENTILATION
 // basic requests for home ventilation system
 
 unsigned long OpenTherm::setVentilationMasterProductVersion(unsigned int hi, unsigned int lo) {
@@ -327,7 +863,7 @@ unsigned long OpenTherm::setVentilationMasterProductVersion(unsigned int hi, uns
 
 unsigned long OpenTherm::getVentilationSlaveProductVersion() {
     // T:OTMessage[READ_DATA,id:127,hi:0,lo:0,Slave product version]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::SlaveVersion, 0);
+    constexpr unsigned long request = buildGetVentilationSlaveProductVersion();
     return sendRequest(request);
 }
 
@@ -345,51 +881,51 @@ unsigned long OpenTherm::setVentilationMasterConfiguration(unsigned int hi, unsi
 
 unsigned long OpenTherm::getVentilationStatus() {
     // T:OTMessage[READ_DATA,id:70,hi:1,lo:0,Status V/H]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::StatusVH, 0);
+    constexpr unsigned long request = buildGetVentilationStatus();
     return sendRequest(request);
 }
 
 bool OpenTherm::isFilterCheck(unsigned int ventilationStatus) {
-    return ventilationStatus & 0x20 == 0x20; // bit 5 (32) set
+    return (ventilationStatus & 0x20) == 0x20; // bit 5 (32) set
 }
 
 unsigned long OpenTherm::setVentilationControlSetpoint(VentilationLevel level) {
     // T:OTMessage[WRITE_DATA,id:71,hi:0,lo:2,Control setpoint V/H]:0
-    unsigned int request = buildSetVentilationControlSetpoint(level);
+    unsigned long request = buildSetVentilationControlSetpoint(level);
     return sendRequest(request);
 }
 
 unsigned long OpenTherm::getVentilationConfigurationMemberId() {
     // T:OTMessage[READ_DATA,id:74,hi:0,lo:0,Configuration/memberid V/H]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::ConfigurationMemberidVH, 0);
+    constexpr unsigned long request = buildReadRequest<OpenThermMessageID::ConfigurationMemberidVH>();
     return sendRequest(request);
 }
 
 unsigned long OpenTherm::getVentilationRelativeVentilation() {
     // T:OTMessage[READ_DATA,id:77,hi:0,lo:0,Relative ventilation]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::RelativeVentilationVH, 0);
+    constexpr unsigned long request = buildReadRequest<OpenThermMessageID::RelativeVentilationVH>();
     return sendRequest(request);
 }
 
 unsigned long OpenTherm::getSupplyInletTemperature() {
     // T:OTMessage[READ_DATA,id:80,hi:0,lo:0,Supply inlet temperature]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::TsupplyInletVH, 0);
+    constexpr unsigned long request = buildReadRequest<OpenThermMessageID::TsupplyInletVH>();
     return sendRequest(request);
 }
 
 unsigned long OpenTherm::getExhaustInletTemperature() {
     //T:OTMessage[READ_DATA,id:82,hi:0,lo:0,Exhaust inlet temperature]:0
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::TexhaustInletVH, 0);
+    constexpr unsigned long request = buildReadRequest<OpenThermMessageID::TexhaustInletVH>();
     return sendRequest(request);
 }
 
 unsigned long OpenTherm::getSupplyOutletTemperature() {
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::TsupplyOutletVH, 0);
+    constexpr unsigned long request = buildReadRequest<OpenThermMessageID::TsupplyOutletVH>();
     return sendRequest(request);
 }
 
 unsigned long OpenTherm::getExhaustOutletTemperature() {
-    unsigned long request = buildRequest(OpenThermRequestType::READ, OpenThermMessageID::TexhaustOutletVH, 0);
+    constexpr unsigned long request = buildReadRequest<OpenThermMessageID::TexhaustOutletVH>();
     return sendRequest(request);
 }
-
+#endif
@@ -15,11 +15,73 @@ P MGS-TYPE SPARE DATA-ID  DATA-VALUE
 
 #include <Arduino.h>
 
+#ifndef OPENTHERM_LATENCY_SAMPLES
+#define OPENTHERM_LATENCY_SAMPLES 8 //response latencies used for adaptive timeout
+#endif
+
+#ifndef OPENTHERM_FIXED_TIMEOUT
+#define OPENTHERM_FIXED_TIMEOUT 0 //us, not 0 - fixed response timeout instead of the adaptive one (1000000 before it)
+#endif
+
+#ifndef OPENTHERM_EDGE_BUFFER_SIZE
+#define OPENTHERM_EDGE_BUFFER_SIZE 128 //power of 2, holds a whole frame (up to 68 edges), see README
+#endif
+static_assert((OPENTHERM_EDGE_BUFFER_SIZE & (OPENTHERM_EDGE_BUFFER_SIZE - 1)) == 0 && OPENTHERM_EDGE_BUFFER_SIZE <= 128,
+	"OPENTHERM_EDGE_BUFFER_SIZE must be a power of 2 up to 128 (byte ring indexes)");
+
+#ifndef OPENTHERM_MAX_BUSES
+#define OPENTHERM_MAX_BUSES 4 //instances with library generated interrupt handler
+#endif
+
+#if defined(ESP8266) || defined(ESP32)
+#define OPENTHERM_ISR_ATTR IRAM_ATTR
+#else
+#define OPENTHERM_ISR_ATTR
+#endif
+
+#ifndef OPENTHERM_STATISTICS
+#define OPENTHERM_STATISTICS 0 //1 - collect bus statistics
+#endif
+
+//features which can be left out on small nodes, request builders and frame codec are always available
+#ifndef OPENTHERM_BOILER
+#define OPENTHERM_BOILER 1 //blocking boiler requests: setBoilerStatus, setBoilerTemperature, getBoilerTemperature
+#endif
+
+#ifndef OPENTHERM_VENTILATION
+#define OPENTHERM_VENTILATION 1 //blocking ventilation V/H requests
+#endif
+
+#ifndef OPENTHERM_CALLBACKS
+#define OPENTHERM_CALLBACKS 1 //0 - no response/request callback, poll isReady/getLastResponse instead
+#endif
+
+//flags changing the object layout are encoded into a symbol defined by OpenTherm.cpp and referenced by the
+//constructor, a sketch built with other flags than the library fails to link (undefined opentherm_config_...)
+//instead of sharing objects of different size
+#define OPENTHERM_CONFIG_NAME(s, c, e, l, b) opentherm_config_s##s##_c##c##_e##e##_l##l##_b##b
+#define OPENTHERM_CONFIG_EXPAND(s, c, e, l, b) OPENTHERM_CONFIG_NAME(s, c, e, l, b)
+#define OPENTHERM_CONFIG OPENTHERM_CONFIG_EXPAND(OPENTHERM_STATISTICS, OPENTHERM_CALLBACKS, \
+	OPENTHERM_EDGE_BUFFER_SIZE, OPENTHERM_LATENCY_SAMPLES, OPENTHERM_MAX_BUSES)
+extern const byte OPENTHERM_CONFIG;
+
 enum OpenThermResponseStatus {
 	NONE,
 	SUCCESS,
 	INVALID,
-	TIMEOUT
+	TIMEOUT,
+	UNKNOWN_ID, //slave answered UNKNOWN-DATAID
+	DATA_REJECTED //slave answered DATA-INVALID
+};
+
+enum OpenThermResponseError {
+	RESPONSE_ERROR_NONE,
+	RESPONSE_ERROR_MANCHESTER, //missing, extra or misplaced edge
+	RESPONSE_ERROR_BIT_COUNT, //frame ended before 32 data bits
+	RESPONSE_ERROR_STOP_BIT,
+	RESPONSE_ERROR_PARITY,
+	RESPONSE_ERROR_MSG_TYPE, //not an ack, UNKNOWN-DATAID or DATA-INVALID
+	RESPONSE_ERROR_DATA_ID //data-id differs from the request
 };
 
 enum OpenThermRequestType {
@@ -27,6 +89,17 @@ enum OpenThermRequestType {
 	WRITE
 };
 
+enum OpenThermMessageType {
+	READ_DATA,
+	WRITE_DATA,
+	INVALID_DATA,
+	RESERVED,
+	READ_ACK,
+	WRITE_ACK,
+	DATA_INVALID,
+	UNKNOWN_DATA_ID
+};
+
 enum OpenThermMessageID {
 	Status, // flag8 / flag8  Master and Slave Status flags. 
 	TSet, // f8.8  Control setpoint  ie CH  water temperature setpoint (°C)
@@ -74,6 +147,8 @@ enum OpenThermMessageID {
 	FaultFlagsVH, // Fault flags/code V/H (otgw matrix only. not (yet) seen on own Vitovent 300)
 	DiagnosticCodeVH, // VHDiagnosticCode
 	ConfigurationMemberidVH,  // Configuration memberid V/H
+	OpenThermVersionVH, // f8.8  OpenTherm version V/H
+	VersionTypeVH, // u8 / u8  Version & type V/H
 	RelativeVentilationVH = 77, // Relative ventilation
 	RelativeHumidityVH, // RelativeHumidity
 	CO2LevelVH, // CO2Level
@@ -105,6 +180,207 @@ enum OpenThermMessageID {
 	SlaveVersion, // u8 / u8  Slave product version number and type
 };
 
+enum OpenThermDataType {
+	DT_FLAG8_FLAG8,
+	DT_FLAG8_U8,
+	DT_U8_U8,
+	DT_S8_S8,
+	DT_U8, // low byte only
+	DT_F88,
+	DT_U16,
+	DT_S16,
+	DT_SPECIAL_U8
+};
+
+enum OpenThermDirection {
+	DIR_READ,
+	DIR_WRITE,
+	DIR_READ_WRITE
+};
+
+enum OpenThermUnit {
+	UNIT_NONE,
+	UNIT_CELSIUS,
+	UNIT_PERCENT,
+	UNIT_BAR,
+	UNIT_LITRES_PER_MINUTE,
+	UNIT_PPM,
+	UNIT_RPM,
+	UNIT_HOURS
+};
+
+// id, data type, direction, unit
+#define OPENTHERM_MESSAGE_TABLE(X) \
+	X(Status, DT_FLAG8_FLAG8, DIR_READ, UNIT_NONE) \
+	X(TSet, DT_F88, DIR_WRITE, UNIT_CELSIUS) \
+	X(MConfigMMemberIDcode, DT_FLAG8_U8, DIR_WRITE, UNIT_NONE) \
+	X(SConfigSMemberIDcode, DT_FLAG8_U8, DIR_READ, UNIT_NONE) \
+	X(Command, DT_U8_U8, DIR_WRITE, UNIT_NONE) \
+	X(ASFflags, DT_FLAG8_U8, DIR_READ, UNIT_NONE) \
+	X(RBPflags, DT_FLAG8_FLAG8, DIR_READ, UNIT_NONE) \
+	X(CoolingControl, DT_F88, DIR_WRITE, UNIT_PERCENT) \
+	X(TsetCH2, DT_F88, DIR_WRITE, UNIT_CELSIUS) \
+	X(TrOverride, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(TSP, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(TSPindexTSPvalue, DT_U8_U8, DIR_READ_WRITE, UNIT_NONE) \
+	X(FHBsize, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(FHBindexFHBvalue, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(MaxRelModLevelSetting, DT_F88, DIR_WRITE, UNIT_PERCENT) \
+	X(MaxCapacityMinModLevel, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(TrSet, DT_F88, DIR_WRITE, UNIT_CELSIUS) \
+	X(RelModLevel, DT_F88, DIR_READ, UNIT_PERCENT) \
+	X(CHPressure, DT_F88, DIR_READ, UNIT_BAR) \
+	X(DHWFlowRate, DT_F88, DIR_READ, UNIT_LITRES_PER_MINUTE) \
+	X(DayTime, DT_SPECIAL_U8, DIR_READ_WRITE, UNIT_NONE) \
+	X(Date, DT_U8_U8, DIR_READ_WRITE, UNIT_NONE) \
+	X(Year, DT_U16, DIR_READ_WRITE, UNIT_NONE) \
+	X(TrSetCH2, DT_F88, DIR_WRITE, UNIT_CELSIUS) \
+	X(Tr, DT_F88, DIR_WRITE, UNIT_CELSIUS) \
+	X(Tboiler, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Tdhw, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Toutside, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Tret, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Tstorage, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Tcollector, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(TflowCH2, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Tdhw2, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(Texhaust, DT_S16, DIR_READ, UNIT_CELSIUS) \
+	X(TdhwSetUBTdhwSetLB, DT_S8_S8, DIR_READ, UNIT_CELSIUS) \
+	X(MaxTSetUBMaxTSetLB, DT_S8_S8, DIR_READ, UNIT_CELSIUS) \
+	X(HcratioUBHcratioLB, DT_S8_S8, DIR_READ, UNIT_NONE) \
+	X(TdhwSet, DT_F88, DIR_READ_WRITE, UNIT_CELSIUS) \
+	X(MaxTSet, DT_F88, DIR_READ_WRITE, UNIT_CELSIUS) \
+	X(Hcratio, DT_F88, DIR_READ_WRITE, UNIT_NONE) \
+	X(StatusVH, DT_FLAG8_FLAG8, DIR_READ, UNIT_NONE) \
+	X(ControlSetpointVH, DT_U8, DIR_WRITE, UNIT_NONE) \
+	X(FaultFlagsVH, DT_FLAG8_U8, DIR_READ, UNIT_NONE) \
+	X(DiagnosticCodeVH, DT_U16, DIR_READ, UNIT_NONE) \
+	X(ConfigurationMemberidVH, DT_FLAG8_U8, DIR_READ, UNIT_NONE) \
+	X(OpenThermVersionVH, DT_F88, DIR_READ, UNIT_NONE) \
+	X(VersionTypeVH, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(RelativeVentilationVH, DT_U8, DIR_READ, UNIT_PERCENT) \
+	X(RelativeHumidityVH, DT_U8, DIR_READ, UNIT_PERCENT) \
+	X(CO2LevelVH, DT_U16, DIR_READ, UNIT_PPM) \
+	X(TsupplyInletVH, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(TsupplyOutletVH, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(TexhaustInletVH, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(TexhaustOutletVH, DT_F88, DIR_READ, UNIT_CELSIUS) \
+	X(ExhaustFanSpeedVH, DT_U16, DIR_READ, UNIT_RPM) \
+	X(InletFanSpeedVH, DT_U16, DIR_READ, UNIT_RPM) \
+	X(VHRemoteParameterVH, DT_FLAG8_FLAG8, DIR_READ, UNIT_NONE) \
+	X(NominalVentilationVH, DT_U8, DIR_READ_WRITE, UNIT_PERCENT) \
+	X(TSPSizeVH, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(TspSettingsVH, DT_U8_U8, DIR_READ_WRITE, UNIT_NONE) \
+	X(FHBSizeVH, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(FHBIndexVH, DT_U8_U8, DIR_READ, UNIT_NONE) \
+	X(RemoteOverrideFunction, DT_FLAG8_FLAG8, DIR_READ, UNIT_NONE) \
+	X(OEMDiagnosticCode, DT_U16, DIR_READ, UNIT_NONE) \
+	X(BurnerStarts, DT_U16, DIR_READ_WRITE, UNIT_NONE) \
+	X(CHPumpStarts, DT_U16, DIR_READ_WRITE, UNIT_NONE) \
+	X(DHWPumpValveStarts, DT_U16, DIR_READ_WRITE, UNIT_NONE) \
+	X(DHWBurnerStarts, DT_U16, DIR_READ_WRITE, UNIT_NONE) \
+	X(BurnerOperationHours, DT_U16, DIR_READ_WRITE, UNIT_HOURS) \
+	X(CHPumpOperationHours, DT_U16, DIR_READ_WRITE, UNIT_HOURS) \
+	X(DHWPumpValveOperationHours, DT_U16, DIR_READ_WRITE, UNIT_HOURS) \
+	X(DHWBurnerOperationHours, DT_U16, DIR_READ_WRITE, UNIT_HOURS) \
+	X(OpenThermVersionMaster, DT_F88, DIR_WRITE, UNIT_NONE) \
+	X(OpenThermVersionSlave, DT_F88, DIR_READ, UNIT_NONE) \
+	X(MasterVersion, DT_U8_U8, DIR_WRITE, UNIT_NONE) \
+	X(SlaveVersion, DT_U8_U8, DIR_READ, UNIT_NONE)
+
+struct OpenThermBytes {
+	byte hb;
+	byte lb;
+};
+
+struct OpenThermSignedBytes {
+	int8_t hb;
+	int8_t lb;
+};
+
+// f8.8 fixed point value (two's complement, 1/256 resolution) to avoid soft-float on AVR/ESP8266
+class OpenThermF88 {
+private:
+	int16_t raw;
+	constexpr OpenThermF88(int16_t raw, bool) : raw(raw) {}
+	static constexpr OpenThermF88 fromLong(long value) {
+		return OpenThermF88((int16_t)(value < -32768 ? -32768 : value > 32767 ? 32767 : value), true);
+	}
+public:
+	constexpr OpenThermF88() : raw(0) {}
+	static constexpr OpenThermF88 fromData(unsigned int data) { return OpenThermF88((int16_t)(data & 0xFFFF), true); }
+	static constexpr OpenThermF88 fromInt(int value) { return fromLong((long)value * 256); }
+	static constexpr OpenThermF88 fromHundredths(long value) { return fromLong((value * 256 + (value < 0 ? -50 : 50)) / 100); }
+	static constexpr OpenThermF88 fromFloat(float value) { return fromLong((long)(value * 256 + (value < 0 ? -0.5f : 0.5f))); }
+
+	constexpr unsigned int toData() const { return (uint16_t)raw; }
+	constexpr int toInt() const { return (raw + (raw < 0 ? -128L : 128L)) / 256; } //rounded
+	constexpr int toHundredths() const { return ((long)raw * 100 + (raw < 0 ? -128 : 128)) / 256; }
+	constexpr float toFloat() const { return raw / 256.0f; }
+	char* toString(char* buffer) const; //"-128.00", buffer of at least 8 chars
+
+	constexpr OpenThermF88 clamp(OpenThermF88 min, OpenThermF88 max) const { return raw < min.raw ? min : raw > max.raw ? max : *this; }
+	constexpr OpenThermF88 operator+(OpenThermF88 other) const { return fromLong((long)raw + other.raw); }
+	constexpr OpenThermF88 operator-(OpenThermF88 other) const { return fromLong((long)raw - other.raw); }
+	constexpr OpenThermF88 operator-() const { return fromLong(-(long)raw); }
+	constexpr bool operator==(OpenThermF88 other) const { return raw == other.raw; }
+	constexpr bool operator!=(OpenThermF88 other) const { return raw != other.raw; }
+	constexpr bool operator<(OpenThermF88 other) const { return raw < other.raw; }
+	constexpr bool operator<=(OpenThermF88 other) const { return raw <= other.raw; }
+	constexpr bool operator>(OpenThermF88 other) const { return raw > other.raw; }
+	constexpr bool operator>=(OpenThermF88 other) const { return raw >= other.raw; }
+};
+
+// decoding/encoding of 16 bit data value by data type
+template<OpenThermDataType T> struct OpenThermData {
+	typedef OpenThermBytes Type;
+	static constexpr Type decode(unsigned int data) { return Type{ (byte)(data >> 8), (byte)(data & 0xFF) }; }
+	static constexpr unsigned int encode(Type value) { return ((unsigned int)value.hb << 8) | value.lb; }
+};
+
+template<> struct OpenThermData<DT_S8_S8> {
+	typedef OpenThermSignedBytes Type;
+	static constexpr Type decode(unsigned int data) { return Type{ (int8_t)(data >> 8), (int8_t)(data & 0xFF) }; }
+	static constexpr unsigned int encode(Type value) { return ((unsigned int)(byte)value.hb << 8) | (byte)value.lb; }
+};
+
+template<> struct OpenThermData<DT_U8> {
+	typedef byte Type;
+	static constexpr Type decode(unsigned int data) { return data & 0xFF; }
+	static constexpr unsigned int encode(Type value) { return value; }
+};
+
+template<> struct OpenThermData<DT_F88> {
+	typedef OpenThermF88 Type;
+	static constexpr Type decode(unsigned int data) { return OpenThermF88::fromData(data); }
+	static constexpr unsigned int encode(Type value) { return value.toData(); }
+};
+
+template<> struct OpenThermData<DT_U16> {
+	typedef uint16_t Type;
+	static constexpr Type decode(unsigned int data) { return data; }
+	static constexpr unsigned int encode(Type value) { return value; }
+};
+
+template<> struct OpenThermData<DT_S16> {
+	typedef int16_t Type;
+	static constexpr Type decode(unsigned int data) { return (int16_t)data; }
+	static constexpr unsigned int encode(Type value) { return (uint16_t)value; }
+};
+
+// compile-time metadata of a data-id, only ids listed in OPENTHERM_MESSAGE_TABLE are defined
+template<OpenThermMessageID ID> struct OpenThermMessage;
+
+#define OPENTHERM_MESSAGE_TRAITS(id, type, dir, u) \
+	template<> struct OpenThermMessage<OpenThermMessageID::id> { \
+		static constexpr OpenThermDataType dataType = type; \
+		static constexpr OpenThermDirection direction = dir; \
+		static constexpr OpenThermUnit unit = u; \
+		typedef OpenThermData<type>::Type Type; \
+	};
+OPENTHERM_MESSAGE_TABLE(OPENTHERM_MESSAGE_TRAITS)
+#undef OPENTHERM_MESSAGE_TRAITS
+
 enum OpenThermStatus {
 	NOT_INITIALIZED,
 	READY,
@@ -117,6 +393,13 @@ enum OpenThermStatus {
 	RESPONSE_INVALID	
 };
 
+// register of slave mode, value is answered to READ_DATA and replaced by WRITE_DATA
+struct OpenThermRegister {
+	OpenThermMessageID id;
+	OpenThermDirection direction; //allowed master access
+	uint16_t value;
+};
+
 enum VentilationLevel {
     VL_OFF     = 0,
     VL_REDUCED = 1,
@@ -124,17 +407,70 @@ enum VentilationLevel {
     VL_HIGH    = 3
 };
 
+#if OPENTHERM_STATISTICS
+#define OPENTHERM_STATISTICS_IDS 8 //data-ids with latency histogram
+#define OPENTHERM_LATENCY_BUCKETS 8 //<50, <100, <150, <200, <300, <400, <600, >=600 ms
+
+struct OpenThermLatencyHistogram {
+	byte id; //0xFF - unused
+	uint16_t buckets[OPENTHERM_LATENCY_BUCKETS]; //request stop bit to response stop bit
+};
+
+struct OpenThermStatistics {
+	unsigned long framesSent;
+	unsigned long success;
+	unsigned long timeout;
+	unsigned long unknownDataId;
+	unsigned long dataInvalid;
+	unsigned long invalid[RESPONSE_ERROR_DATA_ID + 1]; //by OpenThermResponseError
+	unsigned int maxInterruptMicros;
+	unsigned long busyMillis; //frames on the wire
+	unsigned long elapsedMillis; //since reset
+	unsigned long busyWaits; //sendRequest loop runs with pending events
+	unsigned long idleWaits; //sendRequest loop runs after sleeping
+	OpenThermLatencyHistogram latency[OPENTHERM_STATISTICS_IDS];
+};
+#endif
+
 class OpenTherm
 {
 private:
 	const int inPin;
 	const int outPin;	
+	const bool isSlave;
+#if defined(__AVR__)
+	volatile uint8_t *inRegister;
+	volatile uint8_t *outRegister;
+	uint8_t inMask;
+	uint8_t outMask;
+#elif defined(ESP8266)
+	uint32_t inMask; //0 - GPIO16, digitalRead/digitalWrite used
+	uint32_t outMask;
+#endif
 
 	volatile OpenThermStatus status;
 	volatile unsigned long response;
 	volatile OpenThermResponseStatus responseStatus;
+	OpenThermResponseError responseError;
 	volatile unsigned long responseTimestamp;
+	unsigned long requestTimestamp; //end of request stop bit
+	unsigned long frameTimestamp; //last edge of last received frame
+	unsigned long responseTimeout;
+	uint16_t latencies[OPENTHERM_LATENCY_SAMPLES]; //ms, request end to response start bit
+	byte unsupportedIds[16]; //bit per data-id 0..127 answered with UNKNOWN-DATAID
+	byte latencyIndex;
 	volatile byte responseBitIndex;
+	volatile unsigned long request;
+	volatile byte requestHalfBitIndex;
+	bool transmitTimer;
+	volatile uint16_t edges[OPENTHERM_EDGE_BUFFER_SIZE]; //micros() & 0xFFFE | line level
+	volatile byte edgeHead; //written by handleInterrupt only
+	volatile byte edgeTail; //written by process only
+	uint16_t edgeTimestamp;
+	unsigned int halfBitPeriod;
+	bool responseBitEdge;
+	OpenThermRegister *registers; //slave mode
+	byte registerCount;
 	
 	int readState();
 	void setActiveState();
@@ -142,27 +478,138 @@ private:
 	void activateBoiler();
 
 	void sendBit(bool high);
-	bool parity(unsigned long frame);
-	bool isValidResponse(unsigned long response);
+	void sendFrame(unsigned long frame);
+	void listen();
+	void processRequest(OpenThermStatus st, unsigned long ts);
+	void decodeEdges();
+	void setResponseInvalid(OpenThermResponseError error);
+	void updateResponseTimeout(bool timedOut);
+#if OPENTHERM_STATISTICS
+	OpenThermStatistics statistics;
+	unsigned long statisticsTimestamp; //ms
+	unsigned long busyMicros;
+	void recordBusy(unsigned long duration);
+	void recordLatency(byte id, unsigned long latency);
+#endif
+	static constexpr unsigned long foldParity(unsigned long frame, byte shift) { return frame ^ (frame >> shift); }
 	void(*handleInterruptCallback)();
+
+	typedef void(*InterruptHandler)();
+	static OpenTherm *instances[OPENTHERM_MAX_BUSES];
+	static volatile bool pendingEvent; //set by interrupts, cleared by waitForEvent
+	template<byte N> static void OPENTHERM_ISR_ATTR handleInterruptTrampoline() {
+		instances[N]->handleInterrupt();
+	}
+	template<byte N> static InterruptHandler getInterruptTrampoline(byte index) {
+		return index == N ? &handleInterruptTrampoline<N> : getInterruptTrampoline<N - 1>(index);
+	}
+	int registerInstance();
+	void unregisterInstance();
+#if OPENTHERM_CALLBACKS
 	void(*processResponseCallback)(unsigned long, OpenThermResponseStatus);
+#endif
+	void notify(unsigned long frame) {
+#if OPENTHERM_CALLBACKS
+		if (processResponseCallback != NULL) processResponseCallback(frame, responseStatus);
+#endif
+	}
 public:	
-	OpenTherm(int inPin = 4, int outPin = 5);
-	void begin(void(*handleInterruptCallback)(void));
-	void begin(void(*handleInterruptCallback)(void), void(*processResponseCallback)(unsigned long, OpenThermResponseStatus));
+	OpenTherm(int inPin = 4, int outPin = 5, bool isSlave = false, const byte &config = OPENTHERM_CONFIG);
+	bool begin(); //false when all OPENTHERM_MAX_BUSES generated interrupt handlers are in use
+	bool begin(void(*handleInterruptCallback)(void));
+#if OPENTHERM_CALLBACKS
+	bool begin(void(*processResponseCallback)(unsigned long, OpenThermResponseStatus));
+	bool begin(void(*handleInterruptCallback)(void), void(*processResponseCallback)(unsigned long, OpenThermResponseStatus));
+#endif
 	bool isReady();
 	unsigned long sendRequest(unsigned long request);
 	bool sendRequestAync(unsigned long request);
-	unsigned long buildRequest(OpenThermRequestType type, OpenThermMessageID id, unsigned int data);
+	bool sendResponse(unsigned long response);
+
+	//frame codec, usable in constant expressions and from interrupt handlers
+	static constexpr bool parity(unsigned long frame) { //odd parity
+		return (0x6996 >> (foldParity(foldParity(foldParity(frame, 16), 8), 4) & 0xF)) & 1;
+	}
+	static constexpr unsigned long setParity(unsigned long frame) { return frame | ((unsigned long)parity(frame) << 31); }
+	static constexpr unsigned long buildFrame(OpenThermMessageType type, OpenThermMessageID id, unsigned int data) {
+		return setParity(((unsigned long)type << 28) | ((unsigned long)id << 16) | data);
+	}
+	static constexpr unsigned long buildRequest(OpenThermRequestType type, OpenThermMessageID id, unsigned int data) {
+		return buildFrame(type == OpenThermRequestType::WRITE ? OpenThermMessageType::WRITE_DATA : OpenThermMessageType::READ_DATA, id, data);
+	}
+	static constexpr OpenThermMessageType getMessageType(unsigned long frame) { return (OpenThermMessageType)((frame >> 28) & 7); }
+	static constexpr OpenThermMessageID getDataID(unsigned long frame) { return (OpenThermMessageID)((frame >> 16) & 0xFF); }
+	static constexpr unsigned int getData(unsigned long frame) { return frame & 0xFFFF; }
+	static constexpr byte getDataHB(unsigned long frame) { return (frame >> 8) & 0xFF; }
+	static constexpr byte getDataLB(unsigned long frame) { return frame & 0xFF; }
+	static constexpr bool isValidResponse(unsigned long response) { //4 - read ack, 5 - write ack
+		return !parity(response) && ((response >> 29) & 3) == 2;
+	}
+	static constexpr bool isValidRequest(unsigned long request) { //0 - read data, 1 - write data, 2 - invalid data
+		return !parity(request) && ((request >> 28) & 7) < 3;
+	}
+	static constexpr unsigned long buildResponse(OpenThermMessageType type, OpenThermMessageID id, unsigned int data) {
+		return buildFrame(type, id, data);
+	}
+
+	//typed access, data type and direction are resolved at compile time from OpenThermMessage<ID>
+	template<OpenThermMessageID ID> static constexpr typename OpenThermMessage<ID>::Type getValue(unsigned long response) {
+		return OpenThermData<OpenThermMessage<ID>::dataType>::decode(getData(response));
+	}
+	template<OpenThermMessageID ID> static constexpr unsigned long buildReadRequest(unsigned int data = 0) {
+		static_assert(OpenThermMessage<ID>::direction != DIR_WRITE, "data-id is write only");
+		return buildRequest(OpenThermRequestType::READ, ID, data);
+	}
+	template<OpenThermMessageID ID> static constexpr unsigned long buildWriteRequest(typename OpenThermMessage<ID>::Type value) {
+		static_assert(OpenThermMessage<ID>::direction != DIR_READ, "data-id is read only");
+		return buildRequest(OpenThermRequestType::WRITE, ID, OpenThermData<OpenThermMessage<ID>::dataType>::encode(value));
+	}
+	template<OpenThermMessageID ID> typename OpenThermMessage<ID>::Type read(unsigned int data = 0) {
+		return getValue<ID>(sendRequest(buildReadRequest<ID>(data)));
+	}
+	template<OpenThermMessageID ID> bool write(typename OpenThermMessage<ID>::Type value) {
+		return isValidResponse(sendRequest(buildWriteRequest<ID>(value)));
+	}
+	unsigned long getLastResponse();
 	OpenThermResponseStatus getLastResponseStatus();
+	OpenThermResponseError getLastResponseError();
+	unsigned long getResponseTimeout();
+	unsigned long getLastFrameTimestamp();
+	bool isSupported(OpenThermMessageID id);
+	void setSupported(OpenThermMessageID id, bool supported);
+	void resetSupported();
+
+	//slave mode, with outPin -1 listen only monitor accepting requests and responses
+	void setRegisters(OpenThermRegister *registers, byte count);
+	OpenThermRegister *findRegister(OpenThermMessageID id);
+	unsigned long getRegisterResponse(unsigned long request);
+#if OPENTHERM_STATISTICS
+	void getStatistics(OpenThermStatistics &snapshot);
+	void resetStatistics();
+	void printStatistics(Print &out);
+#endif
 	void handleInterrupt();	
+	void handleTimer();
+	void setTransmitTimer(bool enabled);
 	void process();
 	void end();
+	static void processAll();
+	static void handleTimerAll();
+	static bool waitForEvent(); //false if an event was pending, true after sleeping
 
 	//building requests
-	unsigned long buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);
-	unsigned long buildSetBoilerTemperatureRequest(float temperature);
-	unsigned long buildGetBoilerTemperatureRequest();
+	static constexpr unsigned long buildSetBoilerStatusRequest(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false) {
+		return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::Status, (enableCentralHeating | (enableHotWater << 1) | (enableCooling << 2) | (enableOutsideTemperatureCompensation << 3) | (enableCentralHeating2 << 4)) << 8);
+	}
+	static constexpr unsigned long buildSetBoilerTemperatureRequest(float temperature) {
+		return buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::TSet, temperatureToData(temperature));
+	}
+	static constexpr unsigned long buildSetBoilerTemperatureRequest(OpenThermF88 temperature) {
+		return buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::TSet, temperatureToData(temperature));
+	}
+	static constexpr unsigned long buildGetBoilerTemperatureRequest() {
+		return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::Tboiler, 0);
+	}
 
 	//parsing responses
 	bool isFault(unsigned long response);
@@ -172,19 +619,50 @@ public:
 	bool isCoolingEnabled(unsigned long response);
 	bool isDiagnostic(unsigned long response);	
 	float getTemperature(unsigned long response);
-	unsigned int temperatureToData(float temperature);
+	OpenThermF88 getFixedTemperature(unsigned long response);
+	static constexpr unsigned int temperatureToData(OpenThermF88 temperature) {
+		return temperature.clamp(OpenThermF88::fromInt(0), OpenThermF88::fromInt(100)).toData();
+	}
+	static constexpr unsigned int temperatureToData(float temperature) {
+		return temperatureToData(OpenThermF88::fromFloat(temperature));
+	}
 
+#if OPENTHERM_BOILER
 	//basic requests
 	unsigned long setBoilerStatus(bool enableCentralHeating, bool enableHotWater = false, bool enableCooling = false, bool enableOutsideTemperatureCompensation = false, bool enableCentralHeating2 = false);	
 	bool setBoilerTemperature(float temperature);
+	bool setBoilerTemperature(OpenThermF88 temperature);
 	float getBoilerTemperature();
+	OpenThermF88 getFixedBoilerTemperature();
+#endif
 
 	//building requests for home ventilation system
-	unsigned long buildSetVentilationMasterProductVersion(unsigned int hi, unsigned int lo);
-	unsigned long buildGetVentilationTSPSetting(unsigned int index);
-	unsigned long buildSetVentilationMasterConfiguration(unsigned int hi, unsigned int lo);
-	unsigned long buildSetVentilationControlSetpoint(unsigned int level);
+	static constexpr unsigned long buildSetVentilationMasterProductVersion(unsigned int hi, unsigned int lo) {
+		// T:OTMessage[WRITE_DATA,id:126,hi:18,lo:2,Master product version]:0
+		return buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::MasterVersion, (hi << 8) | lo);
+	}
+	static constexpr unsigned long buildGetVentilationSlaveProductVersion() {
+		// T:OTMessage[READ_DATA,id:127,hi:0,lo:0,Slave product version]:0
+		return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::SlaveVersion, 0);
+	}
+	static constexpr unsigned long buildGetVentilationTSPSetting(unsigned int index) {
+		// T:OTMessage[READ_DATA,id:89,hi:18,lo:0,TSP setting V/H]:0
+		return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::TspSettingsVH, index << 8);
+	}
+	static constexpr unsigned long buildSetVentilationMasterConfiguration(unsigned int hi, unsigned int lo) {
+		// T:OTMessage[WRITE_DATA,id:2,hi:0,lo:18,Master configuration]:0
+		return buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::MConfigMMemberIDcode, (hi << 8) | lo);
+	}
+	static constexpr unsigned long buildSetVentilationControlSetpoint(unsigned int level) {
+		// T:OTMessage[WRITE_DATA,id:71,hi:0,lo:2,Control setpoint V/H]:0
+		return buildRequest(OpenThermRequestType::WRITE, OpenThermMessageID::ControlSetpointVH, level);
+	}
+	static constexpr unsigned long buildGetVentilationStatus() {
+		// T:OTMessage[READ_DATA,id:70,hi:1,lo:0,Status V/H]:0
+		return buildRequest(OpenThermRequestType::READ, OpenThermMessageID::StatusVH, 0);
+	}
 
+#if OPENTHERM_VENTILATION
 	//basic requests for home ventilation system
 	unsigned long setVentilationMasterProductVersion(unsigned int hi, unsigned int lo);
 	unsigned long getVentilationSlaveProductVersion();
@@ -203,6 +681,11 @@ public:
 
 	unsigned long getSupplyOutletTemperature();
 	unsigned long getExhaustOutletTemperature();
+#endif
 };
 
+template<> inline OpenTherm::InterruptHandler OpenTherm::getInterruptTrampoline<0>(byte /*index*/) {
+	return &handleInterruptTrampoline<0>;
+}
+
 #endif // OpenTherm_h
@@ -0,0 +1,105 @@
+/*
+OpenThermCache.cpp - cache of last successful responses per data-id
+*/
+
+#include "OpenThermCache.h"
+
+OpenThermCache::OpenThermCache(OpenTherm &ot):
+	ot(ot),
+	size(0)
+{
+}
+
+OpenThermCache::Entry* OpenThermCache::find(OpenThermMessageID id)
+{
+	for (byte i = 0; i < size; i++) {
+		if (entries[i].id == id) return &entries[i];
+	}
+	return NULL;
+}
+
+//evicts least recently updated entry when full
+OpenThermCache::Entry* OpenThermCache::findOrAdd(OpenThermMessageID id)
+{
+	Entry *entry = find(id);
+	if (entry != NULL) return entry;
+	if (size < OPENTHERM_CACHE_SIZE) {
+		entry = &entries[size++];
+	}
+	else {
+		unsigned long now = millis();
+		entry = &entries[0];
+		for (byte i = 1; i < size; i++) {
+			if (now - entries[i].timestamp > now - entry->timestamp) entry = &entries[i];
+		}
+	}
+	entry->id = id;
+	entry->response = 0;
+	entry->timestamp = 0;
+	entry->status = OpenThermResponseStatus::NONE;
+	return entry;
+}
+
+//can be called with responses received elsewhere, e.g. from scheduler or queue handlers
+void OpenThermCache::store(unsigned long response, OpenThermResponseStatus status)
+{
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	Entry *entry = findOrAdd(OpenTherm::getDataID(response));
+	entry->response = response;
+	entry->timestamp = millis();
+	entry->status = status;
+}
+
+bool OpenThermCache::lookup(OpenThermMessageID id, unsigned long maxAge, unsigned long &response)
+{
+	Entry *entry = find(id);
+	if (entry == NULL || entry->response == 0 || millis() - entry->timestamp > maxAge) return false;
+	response = entry->response;
+	return true;
+}
+
+//cached response if not older than maxAge ms, otherwise read request is sent
+unsigned long OpenThermCache::get(OpenThermMessageID id, unsigned long maxAge)
+{
+	unsigned long response;
+	if (lookup(id, maxAge, response)) return response;
+	if (!ot.isReady()) { //bus busy, nothing would be sent: older response or 0, entry is left as is
+		Entry *entry = find(id);
+		return entry != NULL ? entry->response : 0;
+	}
+
+	response = ot.sendRequest(OpenTherm::buildRequest(OpenThermRequestType::READ, id, 0));
+	OpenThermResponseStatus status = ot.getLastResponseStatus();
+	if (status == OpenThermResponseStatus::SUCCESS && OpenTherm::getDataID(response) == id) {
+		store(response, status);
+	}
+	else if (status != OpenThermResponseStatus::NONE) {
+		findOrAdd(id)->status = status;
+	}
+	return response;
+}
+
+OpenThermResponseStatus OpenThermCache::getLastStatus(OpenThermMessageID id)
+{
+	Entry *entry = find(id);
+	return entry != NULL ? entry->status : OpenThermResponseStatus::NONE;
+}
+
+//ms since last successful response, 0xFFFFFFFF if never received
+unsigned long OpenThermCache::getAge(OpenThermMessageID id)
+{
+	Entry *entry = find(id);
+	if (entry == NULL || entry->response == 0) return 0xFFFFFFFF;
+	return millis() - entry->timestamp;
+}
+
+void OpenThermCache::invalidate(OpenThermMessageID id)
+{
+	Entry *entry = find(id);
+	if (entry != NULL) entry->response = 0;
+}
+
+void OpenThermCache::clear()
+{
+	size = 0;
+}
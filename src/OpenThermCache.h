@@ -0,0 +1,52 @@
+/*
+OpenThermCache.h - cache of last successful responses per data-id
+Read-through getters serve cached responses younger than max age and fetch from the bus otherwise,
+so several consumers of the same value share one bus transaction.
+*/
+
+#ifndef OpenThermCache_h
+#define OpenThermCache_h
+
+#include "OpenTherm.h"
+
+#ifndef OPENTHERM_CACHE_SIZE
+#define OPENTHERM_CACHE_SIZE 16
+#endif
+
+class OpenThermCache
+{
+private:
+	struct Entry {
+		unsigned long response; //last successful response
+		unsigned long timestamp; //ms
+		byte id;
+		OpenThermResponseStatus status; //status of last attempt
+	};
+
+	OpenTherm &ot;
+	Entry entries[OPENTHERM_CACHE_SIZE];
+	byte size;
+
+	Entry* find(OpenThermMessageID id);
+	Entry* findOrAdd(OpenThermMessageID id);
+public:
+	OpenThermCache(OpenTherm &ot);
+	void store(unsigned long response, OpenThermResponseStatus status);
+	bool lookup(OpenThermMessageID id, unsigned long maxAge, unsigned long &response);
+	unsigned long get(OpenThermMessageID id, unsigned long maxAge);
+	OpenThermResponseStatus getLastStatus(OpenThermMessageID id);
+	unsigned long getAge(OpenThermMessageID id);
+	void invalidate(OpenThermMessageID id);
+	void clear();
+
+	//false if there is no successful response, e.g. bus busy before the first read or slave error
+	template<OpenThermMessageID ID> bool read(unsigned long maxAge, typename OpenThermMessage<ID>::Type &value) {
+		static_assert(OpenThermMessage<ID>::direction != DIR_WRITE, "data-id is write only");
+		unsigned long response = get(ID, maxAge);
+		if (!OpenTherm::isValidResponse(response) || OpenTherm::getDataID(response) != ID) return false;
+		value = OpenTherm::getValue<ID>(response);
+		return true;
+	}
+};
+
+#endif // OpenThermCache_h
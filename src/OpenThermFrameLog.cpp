@@ -0,0 +1,277 @@
+/*
+OpenThermFrameLog.cpp - compact ring log of request/response pairs
+*/
+
+#include "OpenThermFrameLog.h"
+#include "OpenThermTelemetry.h"
+
+void OpenThermFrameDictionary::clear()
+{
+	size = 0;
+	next = 0;
+}
+
+int OpenThermFrameDictionary::find(unsigned long request)
+{
+	for (byte i = 0; i < size; i++) {
+		if (requests[i] == request) return i;
+	}
+	return -1;
+}
+
+//same message type and data-id, e.g. next TSP index
+int OpenThermFrameDictionary::findId(unsigned long request)
+{
+	for (byte i = 0; i < size; i++) {
+		if (((requests[i] ^ request) & 0x7FFF0000) == 0) return i;
+	}
+	return -1;
+}
+
+void OpenThermFrameDictionary::add(unsigned long request, unsigned long response)
+{
+	byte index = size < OPENTHERM_FRAME_LOG_DICTIONARY ? size++ : next;
+	next = (index + 1) % OPENTHERM_FRAME_LOG_DICTIONARY;
+	requests[index] = request;
+	responses[index] = response;
+}
+
+OpenThermFrameLog::OpenThermFrameLog(byte *buffer, unsigned int size):
+	buffer(buffer),
+	blockCount(size / OPENTHERM_FRAME_LOG_BLOCK_SIZE)
+{
+	clear();
+}
+
+void OpenThermFrameLog::clear()
+{
+	firstBlock = 0;
+	usedBlocks = 0;
+	position = OPENTHERM_FRAME_LOG_BLOCK_SIZE;
+}
+
+unsigned int OpenThermFrameLog::getUsedBytes()
+{
+	if (usedBlocks == 0) return 0;
+	return (usedBlocks - 1) * OPENTHERM_FRAME_LOG_BLOCK_SIZE + position;
+}
+
+unsigned long OpenThermFrameLog::predictResponse(unsigned long request, unsigned int data)
+{
+	OpenThermMessageType type = OpenTherm::getMessageType(request) == WRITE_DATA ? WRITE_ACK : READ_ACK;
+	return OpenTherm::buildResponse(type, OpenTherm::getDataID(request), data);
+}
+
+byte* OpenThermFrameLog::getBlock(unsigned int index)
+{
+	return buffer + ((firstBlock + index) % blockCount) * OPENTHERM_FRAME_LOG_BLOCK_SIZE;
+}
+
+//drops the oldest block when full, block starts with absolute timestamp
+void OpenThermFrameLog::startBlock(unsigned long timestamp)
+{
+	if (usedBlocks < blockCount) {
+		usedBlocks++;
+	}
+	else {
+		firstBlock = (firstBlock + 1) % blockCount;
+	}
+	memset(getBlock(usedBlocks - 1), TAG_END, OPENTHERM_FRAME_LOG_BLOCK_SIZE);
+	position = 0;
+	putLong(timestamp);
+	lastTimestamp = timestamp;
+	dictionary.clear();
+}
+
+void OpenThermFrameLog::put(byte value)
+{
+	getBlock(usedBlocks - 1)[position++] = value;
+}
+
+void OpenThermFrameLog::putLong(unsigned long value)
+{
+	for (byte i = 0; i < 4; i++) put(value >> (24 - 8 * i));
+}
+
+void OpenThermFrameLog::append(unsigned long request, unsigned long response, OpenThermResponseStatus status)
+{
+	append(millis(), request, response, status);
+}
+
+void OpenThermFrameLog::append(unsigned long timestamp, unsigned long request, unsigned long response, OpenThermResponseStatus status)
+{
+	if (blockCount == 0) return;
+	if (position + maxEntrySize > OPENTHERM_FRAME_LOG_BLOCK_SIZE) {
+		startBlock(timestamp);
+	}
+	bool timeout = status == OpenThermResponseStatus::TIMEOUT || status == OpenThermResponseStatus::NONE;
+	if (timeout) response = 0;
+	int index = dictionary.find(request);
+	byte tag = 0;
+	if (index < 0) {
+		index = dictionary.findId(request);
+		if (index >= 0 && OpenTherm::setParity(request & 0x7FFFFFFF) == request) {
+			tag = TAG_REQUEST_DATA | index;
+		}
+		else {
+			index = -1;
+			tag = TAG_NEW;
+		}
+	}
+	else {
+		tag = index;
+	}
+	if (timeout) {
+		tag |= TAG_TIMEOUT;
+	}
+	else if (index < 0 || dictionary.responses[index] != response) {
+		tag |= response == predictResponse(request, OpenTherm::getData(response)) ? TAG_DATA : TAG_RESPONSE;
+	}
+	put(tag);
+	unsigned long delta = timestamp - lastTimestamp;
+	lastTimestamp = timestamp;
+	while (delta >= 0x80) { //varint, 7 bits per byte
+		put(delta | 0x80);
+		delta >>= 7;
+	}
+	put(delta);
+	if (tag & TAG_NEW) {
+		putLong(request);
+	}
+	else if (tag & TAG_REQUEST_DATA) {
+		put(request >> 8);
+		put(request);
+	}
+	if ((tag & TAG_RESPONSE_MASK) == TAG_DATA) {
+		put(response >> 8);
+		put(response);
+	}
+	else if ((tag & TAG_RESPONSE_MASK) == TAG_RESPONSE) {
+		putLong(response);
+	}
+	if (index < 0) {
+		dictionary.add(request, response);
+	}
+	else {
+		dictionary.requests[index] = request;
+		if (!timeout) dictionary.responses[index] = response;
+	}
+}
+
+OpenThermFrameLogReader::OpenThermFrameLogReader(const OpenThermFrameLog &log):
+	log(log)
+{
+	rewind();
+}
+
+void OpenThermFrameLogReader::rewind()
+{
+	block = 0;
+	position = 0;
+}
+
+bool OpenThermFrameLogReader::next(unsigned long &timestamp, unsigned long &request, unsigned long &response, OpenThermResponseStatus &status)
+{
+	while (block < log.usedBlocks) {
+		const byte *data = log.buffer + ((log.firstBlock + block) % log.blockCount) * OPENTHERM_FRAME_LOG_BLOCK_SIZE;
+		unsigned int end = block + 1 == log.usedBlocks ? log.position : OPENTHERM_FRAME_LOG_BLOCK_SIZE;
+		if (position == 0) {
+			this->timestamp = 0;
+			for (; position < 4; position++) this->timestamp = (this->timestamp << 8) | data[position];
+			dictionary.clear();
+		}
+		if (position >= end || data[position] == OpenThermFrameLog::TAG_END) {
+			block++;
+			position = 0;
+			continue;
+		}
+		byte tag = data[position++];
+		unsigned long delta = 0;
+		for (byte shift = 0; ; shift += 7) {
+			byte value = data[position++];
+			delta |= (unsigned long)(value & 0x7F) << shift;
+			if (!(value & 0x80)) break;
+		}
+		this->timestamp += delta;
+		int index = tag & 0x0F;
+		if (tag & OpenThermFrameLog::TAG_NEW) {
+			request = 0;
+			for (byte i = 0; i < 4; i++) request = (request << 8) | data[position++];
+			index = -1;
+		}
+		else if (tag & OpenThermFrameLog::TAG_REQUEST_DATA) {
+			request = OpenTherm::setParity((dictionary.requests[index] & 0x7FFF0000) | ((unsigned int)data[position] << 8) | data[position + 1]);
+			position += 2;
+		}
+		else {
+			request = dictionary.requests[index];
+		}
+		byte kind = tag & OpenThermFrameLog::TAG_RESPONSE_MASK;
+		if (kind == OpenThermFrameLog::TAG_DATA) {
+			response = OpenThermFrameLog::predictResponse(request, ((unsigned int)data[position] << 8) | data[position + 1]);
+			position += 2;
+		}
+		else if (kind == OpenThermFrameLog::TAG_RESPONSE) {
+			response = 0;
+			for (byte i = 0; i < 4; i++) response = (response << 8) | data[position++];
+		}
+		else if (kind == OpenThermFrameLog::TAG_TIMEOUT) {
+			response = 0;
+		}
+		else {
+			response = dictionary.responses[index];
+		}
+		bool timeout = kind == OpenThermFrameLog::TAG_TIMEOUT;
+		if (index < 0) {
+			dictionary.add(request, response);
+		}
+		else {
+			dictionary.requests[index] = request;
+			if (!timeout) dictionary.responses[index] = response;
+		}
+		timestamp = this->timestamp;
+		if (timeout) {
+			status = OpenThermResponseStatus::TIMEOUT;
+		}
+		else if (OpenTherm::parity(response)) {
+			status = OpenThermResponseStatus::INVALID;
+		}
+		else if (OpenTherm::getMessageType(response) == UNKNOWN_DATA_ID) {
+			status = OpenThermResponseStatus::UNKNOWN_ID;
+		}
+		else if (OpenTherm::getMessageType(response) == DATA_INVALID) {
+			status = OpenThermResponseStatus::DATA_REJECTED;
+		}
+		else if (!OpenTherm::isValidResponse(response)) {
+			status = OpenThermResponseStatus::INVALID;
+		}
+		else {
+			status = OpenThermResponseStatus::SUCCESS;
+		}
+		return true;
+	}
+	return false;
+}
+
+void OpenThermFrameLogReader::printFrame(Print &out, unsigned long frame, char source)
+{
+	out.print(source);
+	for (int shift = 28; shift >= 0; shift -= 4) {
+		out.print((frame >> shift) & 0xF, HEX);
+	}
+	out.println();
+	OpenThermTelemetry::printMessage(out, frame, source);
+	out.println();
+}
+
+void OpenThermFrameLogReader::print(Print &out)
+{
+	unsigned long timestamp, request, response;
+	OpenThermResponseStatus status;
+	while (next(timestamp, request, response, status)) {
+		printFrame(out, request, 'T');
+		if (status != OpenThermResponseStatus::TIMEOUT) {
+			printFrame(out, response, 'B');
+		}
+	}
+}
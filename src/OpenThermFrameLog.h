@@ -0,0 +1,91 @@
+/*
+OpenThermFrameLog.h - compact ring log of request/response pairs
+Buffer is split into blocks (e.g. flash sector sized), when full the oldest block is dropped.
+Every block starts with an absolute timestamp and an empty dictionary of the last 16 requests,
+entries hold a tag, time since previous entry (varint, ms) and only what the dictionary can't predict.
+Tag bits:
+0x80 - new request (4 bytes), otherwise request i = tag & 0x0F from the dictionary
+0x40 - request i with new data (2 bytes), e.g. next TSP index
+0x30 - response: 0x00 same as last time, 0x10 ack with new data (2 bytes), 0x20 other frame (4 bytes), 0x30 none
+0xFF - end of block (erased flash)
+A repeating poll cycle takes 3 bytes per request/response pair.
+*/
+
+#ifndef OpenThermFrameLog_h
+#define OpenThermFrameLog_h
+
+#include "OpenTherm.h"
+
+#ifndef OPENTHERM_FRAME_LOG_BLOCK_SIZE
+#define OPENTHERM_FRAME_LOG_BLOCK_SIZE 512
+#endif
+
+#define OPENTHERM_FRAME_LOG_DICTIONARY 16
+
+struct OpenThermFrameDictionary {
+	unsigned long requests[OPENTHERM_FRAME_LOG_DICTIONARY];
+	unsigned long responses[OPENTHERM_FRAME_LOG_DICTIONARY];
+	byte size;
+	byte next; //replaced when full
+
+	void clear();
+	int find(unsigned long request);
+	int findId(unsigned long request);
+	void add(unsigned long request, unsigned long response);
+};
+
+class OpenThermFrameLog
+{
+private:
+	enum Tag {
+		TAG_SAME = 0x00,
+		TAG_DATA = 0x10,
+		TAG_RESPONSE = 0x20,
+		TAG_TIMEOUT = 0x30,
+		TAG_RESPONSE_MASK = 0x30,
+		TAG_REQUEST_DATA = 0x40,
+		TAG_NEW = 0x80,
+		TAG_END = 0xFF
+	};
+	static const byte maxEntrySize = 14; //tag, 5 byte varint, request, response
+
+	byte *buffer;
+	unsigned int blockCount;
+	unsigned int firstBlock;
+	unsigned int usedBlocks;
+	unsigned int position; //in current block
+	unsigned long lastTimestamp;
+	OpenThermFrameDictionary dictionary;
+
+	friend class OpenThermFrameLogReader;
+	static unsigned long predictResponse(unsigned long request, unsigned int data);
+	byte* getBlock(unsigned int index);
+	void startBlock(unsigned long timestamp);
+	void put(byte value);
+	void putLong(unsigned long value);
+public:
+	OpenThermFrameLog(byte *buffer, unsigned int size); //size multiple of OPENTHERM_FRAME_LOG_BLOCK_SIZE
+	void append(unsigned long request, unsigned long response, OpenThermResponseStatus status);
+	void append(unsigned long timestamp, unsigned long request, unsigned long response, OpenThermResponseStatus status);
+	void clear();
+	unsigned int getUsedBytes();
+};
+
+class OpenThermFrameLogReader
+{
+private:
+	const OpenThermFrameLog &log;
+	unsigned int block; //relative to first block
+	unsigned int position;
+	unsigned long timestamp;
+	OpenThermFrameDictionary dictionary;
+
+	static void printFrame(Print &out, unsigned long frame, char source);
+public:
+	OpenThermFrameLogReader(const OpenThermFrameLog &log);
+	void rewind();
+	bool next(unsigned long &timestamp, unsigned long &request, unsigned long &response, OpenThermResponseStatus &status);
+	void print(Print &out); //remaining entries as gateway log text
+};
+
+#endif // OpenThermFrameLog_h
@@ -0,0 +1,134 @@
+/*
+OpenThermGateway.cpp - forwards frames between a thermostat and a boiler
+*/
+
+#include "OpenThermGateway.h"
+
+OpenThermGateway::OpenThermGateway(OpenTherm &boiler, OpenTherm &thermostat):
+	boiler(boiler),
+	thermostat(thermostat),
+	pendingRequest(0),
+	requestPending(false),
+	injectedRequest(0),
+	injectedPending(false),
+	forwardedRequest(0),
+	sending(0),
+	frameCallback(NULL)
+{
+	for (byte i = 0; i < OPENTHERM_GATEWAY_OVERRIDES; i++) {
+		overrides[i].active = false;
+	}
+}
+
+void OpenThermGateway::setFrameCallback(void(*frameCallback)(unsigned long, char, OpenThermResponseStatus))
+{
+	this->frameCallback = frameCallback;
+}
+
+OpenThermGateway::Override* OpenThermGateway::findOverride(OpenThermMessageID id, OpenThermOverride target)
+{
+	for (byte i = 0; i < OPENTHERM_GATEWAY_OVERRIDES; i++) {
+		if (overrides[i].active && overrides[i].id == id && overrides[i].target == target) return &overrides[i];
+	}
+	return NULL;
+}
+
+//returns false if all overrides are in use
+bool OpenThermGateway::setOverride(OpenThermMessageID id, OpenThermOverride target, unsigned int data)
+{
+	Override *entry = findOverride(id, target);
+	for (byte i = 0; i < OPENTHERM_GATEWAY_OVERRIDES && entry == NULL; i++) {
+		if (!overrides[i].active) entry = &overrides[i];
+	}
+	if (entry == NULL) return false;
+	entry->id = id;
+	entry->target = target;
+	entry->data = data;
+	entry->active = true;
+	return true;
+}
+
+void OpenThermGateway::clearOverride(OpenThermMessageID id, OpenThermOverride target)
+{
+	Override *entry = findOverride(id, target);
+	if (entry != NULL) entry->active = false;
+}
+
+//overridden response is always an ack, also when boiler does not know the id
+unsigned long OpenThermGateway::applyOverride(unsigned long frame, OpenThermOverride target)
+{
+	OpenThermMessageID id = OpenTherm::getDataID(frame);
+	Override *entry = findOverride(id, target);
+	if (entry == NULL) return frame;
+	if (target == OpenThermOverride::OVERRIDE_REQUEST) {
+		return OpenTherm::buildFrame(OpenTherm::getMessageType(frame), id, entry->data);
+	}
+	OpenThermMessageType type = OpenTherm::getMessageType(forwardedRequest) == OpenThermMessageType::WRITE_DATA ? OpenThermMessageType::WRITE_ACK : OpenThermMessageType::READ_ACK;
+	return OpenTherm::buildResponse(type, id, entry->data);
+}
+
+void OpenThermGateway::report(unsigned long frame, char source, OpenThermResponseStatus status)
+{
+	if (frameCallback != NULL) {
+		frameCallback(frame, source, status);
+	}
+}
+
+//returns false if previous injected request is not sent yet, response is reported with source B only
+bool OpenThermGateway::inject(unsigned long request)
+{
+	if (injectedPending) return false;
+	injectedRequest = request;
+	injectedPending = true;
+	return true;
+}
+
+//injected and forwarded frame pairs (34ms per frame) with the boiler latency bounded by its response timeout
+//and the delay between them must fit the 800ms the thermostat waits for its response
+bool OpenThermGateway::injectionFits()
+{
+	return 2 * (68000 + boiler.getResponseTimeout()) + 100000 <= 800000;
+}
+
+void OpenThermGateway::handleRequest(unsigned long request, OpenThermResponseStatus status)
+{
+	report(request, 'T', status);
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	pendingRequest = request;
+	requestPending = true;
+}
+
+void OpenThermGateway::process()
+{
+	thermostat.process();
+	boiler.process();
+
+	if (sending != 0) {
+		OpenThermResponseStatus status = boiler.getLastResponseStatus();
+		if (status == OpenThermResponseStatus::NONE) return;
+		unsigned long response = boiler.getLastResponse();
+		report(response, 'B', status);
+		//unknown data-id and data invalid responses are passed to thermostat too
+		bool valid = status == OpenThermResponseStatus::SUCCESS || status == OpenThermResponseStatus::UNKNOWN_ID || status == OpenThermResponseStatus::DATA_REJECTED;
+		if (sending == 1 && valid) {
+			unsigned long answer = applyOverride(response, OpenThermOverride::OVERRIDE_RESPONSE);
+			if (answer != response) report(answer, 'A', OpenThermResponseStatus::SUCCESS);
+			thermostat.sendResponse(answer);
+		}
+		sending = 0;
+	}
+
+	if (!boiler.isReady()) return;
+	if (requestPending) {
+		requestPending = false;
+		forwardedRequest = pendingRequest;
+		unsigned long request = applyOverride(forwardedRequest, OpenThermOverride::OVERRIDE_REQUEST);
+		if (request != forwardedRequest) report(request, 'R', OpenThermResponseStatus::SUCCESS);
+		if (boiler.sendRequestAync(request)) sending = 1;
+	}
+	else if (injectedPending && injectionFits()) {
+		injectedPending = false;
+		forwardedRequest = injectedRequest;
+		if (boiler.sendRequestAync(injectedRequest)) sending = 2;
+	}
+}
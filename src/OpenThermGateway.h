@@ -0,0 +1,61 @@
+/*
+OpenThermGateway.h - forwards frames between a thermostat and a boiler
+Thermostat is connected to an OpenTherm instance in slave mode, boiler to one in master mode.
+Requests of the thermostat are sent to the boiler as soon as the boiler bus is free, responses are
+returned to the thermostat right away. Selected ids can be overridden in either direction and own
+requests can be injected between thermostat requests. An injected request is held back while the boiler is too slow
+for it, the 100ms delay and a thermostat request arriving meanwhile to fit the 800ms response window of the thermostat.
+Every frame is reported to the frame callback with its source like in gateway logs:
+T - thermostat request, B - boiler response, R - request sent to boiler instead of T, A - answer sent to thermostat instead of B.
+*/
+
+#ifndef OpenThermGateway_h
+#define OpenThermGateway_h
+
+#include "OpenTherm.h"
+
+#ifndef OPENTHERM_GATEWAY_OVERRIDES
+#define OPENTHERM_GATEWAY_OVERRIDES 4
+#endif
+
+enum OpenThermOverride {
+	OVERRIDE_REQUEST, //data of thermostat request is replaced
+	OVERRIDE_RESPONSE //data of boiler response is replaced
+};
+
+class OpenThermGateway
+{
+private:
+	struct Override {
+		byte id;
+		byte target; //OpenThermOverride
+		bool active;
+		uint16_t data;
+	};
+
+	OpenTherm &boiler;
+	OpenTherm &thermostat;
+	Override overrides[OPENTHERM_GATEWAY_OVERRIDES];
+	unsigned long pendingRequest; //thermostat request waiting for boiler bus
+	bool requestPending;
+	unsigned long injectedRequest;
+	bool injectedPending;
+	unsigned long forwardedRequest; //last request sent to boiler, before override
+	byte sending; //0 - nothing, 1 - thermostat request, 2 - injected request
+	void(*frameCallback)(unsigned long, char, OpenThermResponseStatus);
+
+	Override* findOverride(OpenThermMessageID id, OpenThermOverride target);
+	unsigned long applyOverride(unsigned long frame, OpenThermOverride target);
+	void report(unsigned long frame, char source, OpenThermResponseStatus status);
+	bool injectionFits();
+public:
+	OpenThermGateway(OpenTherm &boiler, OpenTherm &thermostat);
+	void setFrameCallback(void(*frameCallback)(unsigned long frame, char source, OpenThermResponseStatus status));
+	bool setOverride(OpenThermMessageID id, OpenThermOverride target, unsigned int data);
+	void clearOverride(OpenThermMessageID id, OpenThermOverride target);
+	bool inject(unsigned long request);
+	void handleRequest(unsigned long request, OpenThermResponseStatus status); //call from thermostat callback
+	void process();
+};
+
+#endif // OpenThermGateway_h
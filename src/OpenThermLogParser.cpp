@@ -0,0 +1,117 @@
+/*
+OpenThermLogParser.cpp - streaming parser for gateway logs
+*/
+
+#include "OpenThermLogParser.h"
+
+OpenThermLogParser::OpenThermLogParser(void(*callback)(unsigned long, unsigned long, OpenThermResponseStatus)):
+	frame(0),
+	digits(0),
+	source(0),
+	request(0),
+	requestPending(false),
+	frameCount(0),
+	invalidCount(0),
+	callback(callback)
+{
+}
+
+void OpenThermLogParser::setCallback(void(*callback)(unsigned long, unsigned long, OpenThermResponseStatus))
+{
+	this->callback = callback;
+}
+
+size_t OpenThermLogParser::write(uint8_t c)
+{
+	if (c == '\n' || c == '\r') {
+		endLine();
+		return 1;
+	}
+	if (digits == 0xFF) return 1;
+	if (source == 0) {
+		if (c == 'T' || c == 'B' || c == 'R' || c == 'A') source = c;
+		else digits = 0xFF;
+		return 1;
+	}
+
+	byte value;
+	if (c >= '0' && c <= '9') value = c - '0';
+	else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+	else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+	else value = 0xFF;
+	if (value == 0xFF || digits == 8) { //T:OTMessage[...] or other text
+		digits = 0xFF;
+		return 1;
+	}
+	frame = (frame << 4) | value;
+	digits++;
+	return 1;
+}
+
+void OpenThermLogParser::endLine()
+{
+	if (digits == 8) {
+		handleFrame(source, frame);
+	}
+	frame = 0;
+	digits = 0;
+	source = 0;
+}
+
+void OpenThermLogParser::end()
+{
+	endLine();
+	if (requestPending && callback != NULL) {
+		callback(request, 0, OpenThermResponseStatus::TIMEOUT);
+	}
+	requestPending = false;
+}
+
+//R replaces the pending T request, A after an already paired B is skipped
+void OpenThermLogParser::handleFrame(char source, unsigned long frame)
+{
+	frameCount++;
+	if (source == 'T' || source == 'R') {
+		if (requestPending && source == 'T' && callback != NULL) {
+			callback(request, 0, OpenThermResponseStatus::TIMEOUT);
+		}
+		requestPending = OpenTherm::isValidRequest(frame);
+		if (!requestPending) invalidCount++;
+		request = frame;
+		return;
+	}
+
+	if (!requestPending) {
+		if (source == 'B') invalidCount++;
+		return;
+	}
+	requestPending = false;
+	OpenThermResponseStatus status = OpenThermResponseStatus::SUCCESS;
+	if (OpenTherm::parity(frame) || OpenTherm::getDataID(frame) != OpenTherm::getDataID(request)) {
+		status = OpenThermResponseStatus::INVALID;
+	}
+	else if (OpenTherm::getMessageType(frame) == OpenThermMessageType::UNKNOWN_DATA_ID) {
+		status = OpenThermResponseStatus::UNKNOWN_ID;
+	}
+	else if (OpenTherm::getMessageType(frame) == OpenThermMessageType::DATA_INVALID) {
+		status = OpenThermResponseStatus::DATA_REJECTED;
+	}
+	else if (!OpenTherm::isValidResponse(frame)) {
+		status = OpenThermResponseStatus::INVALID;
+	}
+	if (status == OpenThermResponseStatus::INVALID) invalidCount++;
+	if (callback != NULL) {
+		callback(request, frame, status);
+	}
+}
+
+unsigned long OpenThermLogParser::getFrameCount()
+{
+	return frameCount;
+}
+
+//requests with wrong parity or message type, responses not matching request
+unsigned long OpenThermLogParser::getInvalidCount()
+{
+	return invalidCount;
+}
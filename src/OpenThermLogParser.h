@@ -0,0 +1,38 @@
+/*
+OpenThermLogParser.h - streaming parser for gateway logs
+Frame lines (T80593800, B40593877, R/A for frames changed by a gateway) are parsed while characters are written,
+other lines (OTMessage text) are skipped. Memory use is constant, logs can be written from any source (Stream, file, buffer).
+Frames are checked with the parity and message type rules of OpenTherm, every request is paired with the following
+response and passed to the callback, requests without response are passed with TIMEOUT status.
+*/
+
+#ifndef OpenThermLogParser_h
+#define OpenThermLogParser_h
+
+#include "OpenTherm.h"
+
+class OpenThermLogParser : public Print
+{
+private:
+	unsigned long frame;
+	byte digits; //hex digits of current line, 0xFF - line is skipped
+	char source; //first character of current line
+	unsigned long request;
+	bool requestPending;
+	unsigned long frameCount;
+	unsigned long invalidCount;
+	void(*callback)(unsigned long, unsigned long, OpenThermResponseStatus);
+
+	void endLine();
+	void handleFrame(char source, unsigned long frame);
+public:
+	OpenThermLogParser(void(*callback)(unsigned long request, unsigned long response, OpenThermResponseStatus status) = NULL);
+	void setCallback(void(*callback)(unsigned long request, unsigned long response, OpenThermResponseStatus status));
+	virtual size_t write(uint8_t c);
+	using Print::write;
+	void end(); //completes last line and pending request
+	unsigned long getFrameCount();
+	unsigned long getInvalidCount();
+};
+
+#endif // OpenThermLogParser_h
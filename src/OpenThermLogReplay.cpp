@@ -0,0 +1,71 @@
+/*
+OpenThermLogReplay.cpp - answers requests of a master with responses recorded in a gateway log
+*/
+
+#include "OpenThermLogReplay.h"
+
+OpenThermLogReplay::OpenThermLogReplay(OpenTherm &ot):
+	ot(ot),
+	count(0),
+	next(0)
+{
+}
+
+//latest response of a request wins, oldest stored request is replaced when full
+void OpenThermLogReplay::store(unsigned long request, unsigned long response, OpenThermResponseStatus status)
+{
+	if (status == OpenThermResponseStatus::TIMEOUT || OpenTherm::parity(response)) return;
+	request &= 0x7FFFFFFF;
+	for (byte i = 0; i < count; i++) {
+		if (entries[i].request == request) {
+			entries[i].response = response;
+			return;
+		}
+	}
+	byte index = count;
+	if (count < OPENTHERM_REPLAY_SIZE) {
+		count++;
+	}
+	else {
+		index = next;
+		next = (next + 1) % OPENTHERM_REPLAY_SIZE;
+	}
+	entries[index].request = request;
+	entries[index].response = response;
+}
+
+unsigned long OpenThermLogReplay::getResponse(unsigned long request)
+{
+	OpenThermMessageType type = OpenTherm::getMessageType(request);
+	OpenThermMessageID id = OpenTherm::getDataID(request);
+	bool knownId = false;
+	request &= 0x7FFFFFFF;
+	for (byte i = 0; i < count; i++) {
+		if (entries[i].request == request) return entries[i].response;
+		if (OpenTherm::getDataID(entries[i].request) == id) knownId = true;
+	}
+	if (!knownId) {
+		return OpenTherm::buildResponse(OpenThermMessageType::UNKNOWN_DATA_ID, id, OpenTherm::getData(request));
+	}
+	if (type == OpenThermMessageType::WRITE_DATA) {
+		return OpenTherm::buildResponse(OpenThermMessageType::WRITE_ACK, id, OpenTherm::getData(request));
+	}
+	return OpenTherm::buildResponse(OpenThermMessageType::DATA_INVALID, id, OpenTherm::getData(request));
+}
+
+void OpenThermLogReplay::handleRequest(unsigned long request, OpenThermResponseStatus status)
+{
+	if (status != OpenThermResponseStatus::SUCCESS) return;
+	ot.sendResponse(getResponse(request));
+}
+
+byte OpenThermLogReplay::getCount()
+{
+	return count;
+}
+
+void OpenThermLogReplay::clear()
+{
+	count = 0;
+	next = 0;
+}
@@ -0,0 +1,39 @@
+/*
+OpenThermLogReplay.h - answers requests of a master with responses recorded in a gateway log
+Request/response pairs are stored from OpenThermLogParser and sent by an OpenTherm instance in slave mode.
+Requests are matched including data (e.g. TSP index), writes of other values to a known id are acknowledged,
+reads of a known id with other data get DATA-INVALID and unknown ids UNKNOWN-DATAID.
+*/
+
+#ifndef OpenThermLogReplay_h
+#define OpenThermLogReplay_h
+
+#include "OpenTherm.h"
+
+#ifndef OPENTHERM_REPLAY_SIZE
+#define OPENTHERM_REPLAY_SIZE 48 //distinct requests (8 bytes each), vitovent300.log.txt has 40
+#endif
+
+class OpenThermLogReplay
+{
+private:
+	struct Entry {
+		unsigned long request; //without parity
+		unsigned long response;
+	};
+
+	OpenTherm &ot;
+	Entry entries[OPENTHERM_REPLAY_SIZE];
+	byte count;
+	byte next; //replaced when full
+
+public:
+	OpenThermLogReplay(OpenTherm &ot);
+	void store(unsigned long request, unsigned long response, OpenThermResponseStatus status);
+	unsigned long getResponse(unsigned long request);
+	void handleRequest(unsigned long request, OpenThermResponseStatus status); //call from slave callback
+	byte getCount();
+	void clear();
+};
+
+#endif // OpenThermLogReplay_h
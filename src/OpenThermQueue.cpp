@@ -0,0 +1,172 @@
+/*
+OpenThermQueue.cpp - shared request queue for OpenTherm master
+*/
+
+#include "OpenThermQueue.h"
+
+//slot state is the only field shared between producers and process(), the other fields are owned by whoever
+//moved the state: submit from CLAIMED to QUEUED, process from QUEUED to DONE, the handle owner from DONE to FREE
+#if defined(__AVR__) || defined(ESP8266)
+//single core without compare-and-swap instruction
+static bool compareAndSwap(volatile byte &state, byte expected, byte desired)
+{
+	noInterrupts();
+	bool swapped = state == expected;
+	if (swapped) state = desired;
+	interrupts();
+	return swapped;
+}
+
+static byte fetchAndIncrement(byte &value)
+{
+	noInterrupts();
+	byte old = value++;
+	interrupts();
+	return old;
+}
+
+static inline byte loadState(const volatile byte &state)
+{
+	return state;
+}
+
+static inline void storeState(volatile byte &state, byte value)
+{
+	state = value;
+}
+#else
+static bool compareAndSwap(volatile byte &state, byte expected, byte desired)
+{
+	return __atomic_compare_exchange_n(&state, &expected, desired, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static byte fetchAndIncrement(byte &value)
+{
+	return __atomic_fetch_add(&value, 1, __ATOMIC_RELAXED);
+}
+
+static inline byte loadState(const volatile byte &state)
+{
+	return __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+}
+
+static inline void storeState(volatile byte &state, byte value)
+{
+	__atomic_store_n(&state, value, __ATOMIC_RELEASE);
+}
+#endif
+
+//handle: bits 0..3 - slot index, bits 4..14 - slot generation, -1 - no handle
+OpenThermQueue::OpenThermQueue(OpenTherm &ot):
+	ot(ot),
+	sequence(0),
+	sending(NO_SLOT)
+{
+	for (byte i = 0; i < OPENTHERM_QUEUE_SIZE; i++) {
+		slots[i].state = SLOT_FREE;
+		slots[i].generation = 0;
+	}
+}
+
+OpenThermQueue::Slot* OpenThermQueue::getSlot(int handle)
+{
+	if (handle < 0) return NULL;
+	byte index = handle & 0x0F;
+	if (index >= OPENTHERM_QUEUE_SIZE) return NULL;
+	Slot *slot = &slots[index];
+	if (loadState(slot->state) == SLOT_FREE || slot->generation != ((unsigned int)handle >> 4)) return NULL;
+	return slot;
+}
+
+//returns -1 if queue is full, callback requests are released automatically after callback
+int OpenThermQueue::submit(unsigned long request, void(*callback)(int, unsigned long, OpenThermResponseStatus))
+{
+	byte index = 0;
+	while (index < OPENTHERM_QUEUE_SIZE && !compareAndSwap(slots[index].state, SLOT_FREE, SLOT_CLAIMED)) index++;
+	if (index == OPENTHERM_QUEUE_SIZE) return -1;
+	Slot &slot = slots[index];
+	slot.sequence = fetchAndIncrement(sequence);
+	slot.generation = (slot.generation + 1) & 0x7FF;
+	slot.request = request;
+	slot.response = 0;
+	slot.responseStatus = OpenThermResponseStatus::NONE;
+	slot.callback = callback;
+	int handle = (slot.generation << 4) | index;
+	storeState(slot.state, SLOT_QUEUED);
+	return handle;
+}
+
+bool OpenThermQueue::isDone(int handle)
+{
+	Slot *slot = getSlot(handle);
+	return slot != NULL && loadState(slot->state) == SLOT_DONE;
+}
+
+unsigned long OpenThermQueue::getResponse(int handle)
+{
+	Slot *slot = getSlot(handle);
+	return slot != NULL && loadState(slot->state) == SLOT_DONE ? slot->response : 0;
+}
+
+OpenThermResponseStatus OpenThermQueue::getResponseStatus(int handle)
+{
+	Slot *slot = getSlot(handle);
+	return slot != NULL && loadState(slot->state) == SLOT_DONE ? slot->responseStatus : OpenThermResponseStatus::NONE;
+}
+
+//frees slot of completed polled request
+void OpenThermQueue::release(int handle)
+{
+	Slot *slot = getSlot(handle);
+	if (slot != NULL && loadState(slot->state) == SLOT_DONE) storeState(slot->state, SLOT_FREE);
+}
+
+byte OpenThermQueue::pendingCount()
+{
+	byte count = 0;
+	for (byte i = 0; i < OPENTHERM_QUEUE_SIZE; i++) {
+		if (loadState(slots[i].state) == SLOT_QUEUED) count++;
+	}
+	return count;
+}
+
+//oldest queued slot
+byte OpenThermQueue::nextQueued()
+{
+	byte next = NO_SLOT;
+	for (byte i = 0; i < OPENTHERM_QUEUE_SIZE; i++) {
+		if (loadState(slots[i].state) != SLOT_QUEUED) continue;
+		if (next == NO_SLOT || (int8_t)(slots[i].sequence - slots[next].sequence) < 0) next = i;
+	}
+	return next;
+}
+
+void OpenThermQueue::process()
+{
+	ot.process();
+
+	if (sending != NO_SLOT) {
+		OpenThermResponseStatus status = ot.getLastResponseStatus();
+		if (status == OpenThermResponseStatus::NONE) return;
+		Slot &slot = slots[sending];
+		sending = NO_SLOT;
+		slot.response = ot.getLastResponse();
+		slot.responseStatus = status;
+		if (slot.callback != NULL) {
+			storeState(slot.state, SLOT_DONE);
+			slot.callback((slot.generation << 4) | (&slot - slots), slot.response, status);
+			storeState(slot.state, SLOT_FREE);
+		}
+		else {
+			storeState(slot.state, SLOT_DONE);
+		}
+	}
+
+	if (!ot.isReady()) return;
+	byte next = nextQueued();
+	if (next == NO_SLOT) return;
+	if (ot.sendRequestAync(slots[next].request)) {
+		storeState(slots[next].state, SLOT_SENDING);
+		sending = next;
+	}
+}
@@ -0,0 +1,60 @@
+/*
+OpenThermQueue.h - shared request queue for OpenTherm master
+Lets several producers (control loop, console, web handler, interrupts) submit requests to one bus.
+Every request gets a handle which can be polled or completed by callback.
+Slots are claimed by compare-and-swap on the slot state, producers on other cores, tasks or
+interrupts never wait for each other or for the bus (AVR and ESP8266: a few instruction critical section).
+process() is the only consumer and must not be mixed with direct sendRequest calls on the same bus.
+*/
+
+#ifndef OpenThermQueue_h
+#define OpenThermQueue_h
+
+#include "OpenTherm.h"
+
+#ifndef OPENTHERM_QUEUE_SIZE
+#define OPENTHERM_QUEUE_SIZE 8 //up to 16
+#endif
+
+class OpenThermQueue
+{
+private:
+	enum SlotState {
+		SLOT_FREE,
+		SLOT_CLAIMED, //being filled by submit, not visible to process yet
+		SLOT_QUEUED,
+		SLOT_SENDING,
+		SLOT_DONE
+	};
+
+	struct Slot {
+		unsigned long request;
+		unsigned long response;
+		volatile byte state;
+		byte sequence;
+		OpenThermResponseStatus responseStatus;
+		unsigned int generation;
+		void(*callback)(int, unsigned long, OpenThermResponseStatus);
+	};
+
+	static const byte NO_SLOT = 0xFF;
+
+	OpenTherm &ot;
+	Slot slots[OPENTHERM_QUEUE_SIZE];
+	byte sequence;
+	byte sending;
+
+	Slot* getSlot(int handle);
+	byte nextQueued();
+public:
+	OpenThermQueue(OpenTherm &ot);
+	int submit(unsigned long request, void(*callback)(int handle, unsigned long response, OpenThermResponseStatus status) = NULL);
+	bool isDone(int handle);
+	unsigned long getResponse(int handle);
+	OpenThermResponseStatus getResponseStatus(int handle);
+	void release(int handle);
+	byte pendingCount();
+	void process();
+};
+
+#endif // OpenThermQueue_h
@@ -0,0 +1,170 @@
+/*
+OpenThermScheduler.cpp - periodic request scheduler for OpenTherm master
+*/
+
+#include "OpenThermScheduler.h"
+
+OpenThermScheduler::OpenThermScheduler(OpenTherm &ot):
+	ot(ot),
+	size(0),
+	transferCount(0),
+	nextTransfer(0),
+	pending(NO_ENTRY),
+	lastSent(0)
+{
+}
+
+//returns entry index or -1 if scheduler is full, new entries are due immediately
+int OpenThermScheduler::add(unsigned long request, unsigned long period, byte priority, void(*handler)(unsigned long, OpenThermResponseStatus))
+{
+	if (size >= OPENTHERM_SCHEDULER_SIZE) return -1;
+	Entry &entry = entries[size];
+	entry.request = request;
+	entry.period = period;
+	entry.lastSent = millis() - period;
+	entry.priority = priority;
+	entry.flags = 0;
+	entry.handler = handler;
+	return size++;
+}
+
+//write entry, sent right away and then on value change or when refresh (ms) expires
+int OpenThermScheduler::addWrite(unsigned long request, unsigned long refresh, byte priority, void(*handler)(unsigned long, OpenThermResponseStatus))
+{
+	int index = add(request, refresh, priority, handler);
+	if (index >= 0) entries[index].flags = ENTRY_WRITE | ENTRY_DIRTY;
+	return index;
+}
+
+//write entries are only sent again if data changes
+void OpenThermScheduler::setRequest(int index, unsigned long request)
+{
+	if (index < 0 || index >= size || entries[index].request == request) return;
+	entries[index].request = request;
+	if (entries[index].flags & ENTRY_WRITE) entries[index].flags = ENTRY_WRITE | ENTRY_DIRTY;
+}
+
+void OpenThermScheduler::setData(int index, unsigned int data)
+{
+	if (index < 0 || index >= size) return;
+	unsigned long request = entries[index].request;
+	setRequest(index, OpenTherm::buildFrame(OpenTherm::getMessageType(request), OpenTherm::getDataID(request), data));
+}
+
+//slave acknowledged current value of write entry
+bool OpenThermScheduler::isConfirmed(int index)
+{
+	return index >= 0 && index < size && (entries[index].flags & ENTRY_CONFIRMED);
+}
+
+void OpenThermScheduler::setPeriod(int index, unsigned long period)
+{
+	if (index >= 0 && index < size) entries[index].period = period;
+}
+
+//returns false if OPENTHERM_SCHEDULER_TRANSFERS are added already
+bool OpenThermScheduler::addTransfer(OpenThermTransfer &transfer)
+{
+	if (transferCount >= OPENTHERM_SCHEDULER_TRANSFERS) return false;
+	transfers[transferCount++] = &transfer;
+	return true;
+}
+
+//unsupported data-ids back off to reprobe interval, failed writes are retried sooner
+unsigned long OpenThermScheduler::getPeriod(byte index)
+{
+	unsigned long period = entries[index].period;
+	byte failures = (entries[index].flags & ENTRY_FAILURES) / ENTRY_FAILURE;
+	if (failures > 0 && failures <= OPENTHERM_RETRIES && ((unsigned long)OPENTHERM_RETRY_INTERVAL << (failures - 1)) < period) {
+		period = (unsigned long)OPENTHERM_RETRY_INTERVAL << (failures - 1);
+	}
+	if (period < OPENTHERM_REPROBE_INTERVAL && !ot.isSupported(OpenTherm::getDataID(entries[index].request))) {
+		period = OPENTHERM_REPROBE_INTERVAL;
+	}
+	return period;
+}
+
+//highest priority due entry, the most overdue one wins within same priority,
+//if nothing is due but keep alive interval expired the entry due next is sent
+byte OpenThermScheduler::nextEntry(unsigned long now)
+{
+	byte next = NO_ENTRY;
+	long nextOverdue = 0;
+	for (byte i = 0; i < size; i++) {
+		long overdue = (entries[i].flags & ENTRY_DIRTY) ? (long)(now - entries[i].lastSent) : (long)(now - entries[i].lastSent - getPeriod(i));
+		if (overdue < 0) continue;
+		if (next == NO_ENTRY || entries[i].priority > entries[next].priority
+			|| (entries[i].priority == entries[next].priority && overdue > nextOverdue)) {
+			next = i;
+			nextOverdue = overdue;
+		}
+	}
+	if (next != NO_ENTRY || now - lastSent < keepAliveInterval) return next;
+
+	for (byte i = 0; i < size; i++) {
+		long overdue = (long)(now - entries[i].lastSent - getPeriod(i));
+		if (next == NO_ENTRY || overdue > nextOverdue) {
+			next = i;
+			nextOverdue = overdue;
+		}
+	}
+	return next;
+}
+
+void OpenThermScheduler::process()
+{
+	ot.process();
+
+	if (pending != NO_ENTRY) {
+		OpenThermResponseStatus status = ot.getLastResponseStatus();
+		if (status == OpenThermResponseStatus::NONE) return;
+		byte index = pending;
+		pending = NO_ENTRY;
+		if (index & TRANSFER_ENTRY) {
+			transfers[index & ~TRANSFER_ENTRY]->handleResponse(ot.getLastResponse(), status);
+		}
+		else {
+			Entry &entry = entries[index];
+			unsigned long response = ot.getLastResponse();
+			if (entry.flags & ENTRY_WRITE) {
+				bool acknowledged = status == OpenThermResponseStatus::SUCCESS && OpenTherm::getMessageType(response) == OpenThermMessageType::WRITE_ACK
+					&& OpenTherm::getData(response) == OpenTherm::getData(entry.request);
+				if (!acknowledged) entry.flags &= ~ENTRY_CONFIRMED;
+				else if (!(entry.flags & ENTRY_DIRTY)) entry.flags |= ENTRY_CONFIRMED; //not changed while sending
+				if (status != OpenThermResponseStatus::TIMEOUT && status != OpenThermResponseStatus::INVALID) {
+					entry.flags &= ~ENTRY_FAILURES;
+				}
+				else if ((entry.flags & ENTRY_FAILURES) != ENTRY_FAILURES) {
+					entry.flags += ENTRY_FAILURE; //retried after backoff, see getPeriod
+				}
+			}
+			if (entry.handler != NULL) {
+				entry.handler(response, status);
+			}
+		}
+	}
+
+	if (!ot.isReady()) return;
+	unsigned long now = millis();
+	byte next = nextEntry(now);
+	if (next == NO_ENTRY) {
+		//idle slot, transfers take turns
+		for (byte i = 0; i < transferCount; i++) {
+			byte t = (nextTransfer + i) % transferCount;
+			unsigned long request;
+			if (transfers[t]->nextRequest(request) && ot.sendRequestAync(request)) {
+				nextTransfer = (t + 1) % transferCount;
+				lastSent = now;
+				pending = TRANSFER_ENTRY | t;
+				return;
+			}
+		}
+		return;
+	}
+	if (ot.sendRequestAync(entries[next].request)) {
+		entries[next].flags &= ~ENTRY_DIRTY;
+		entries[next].lastSent = now;
+		lastSent = now;
+		pending = next;
+	}
+}
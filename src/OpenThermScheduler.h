@@ -0,0 +1,92 @@
+/*
+OpenThermScheduler.h - periodic request scheduler for OpenTherm master
+Keeps the bus busy with registered requests: every request is sent when its period expires,
+due requests are ordered by priority and the slave is kept alive even when nothing is due.
+Slots where nothing is due are given to bulk transfers (OpenThermTransfer) in turn.
+Requests of data-ids the slave answered with UNKNOWN-DATAID are only sent every reprobe interval.
+Write entries shadow the written value: they are sent when the value changes (latest value only) or
+their refresh interval expires, and remember whether the slave acknowledged the current value.
+A write which got no valid response is retried after 1, 2 and 4 s (OPENTHERM_RETRY_INTERVAL, doubling),
+then only every refresh interval, so a silent slave does not take all bus slots.
+*/
+
+#ifndef OpenThermScheduler_h
+#define OpenThermScheduler_h
+
+#include "OpenTherm.h"
+#include "OpenThermTransfer.h"
+
+#ifndef OPENTHERM_SCHEDULER_SIZE
+#define OPENTHERM_SCHEDULER_SIZE 16
+#endif
+
+#ifndef OPENTHERM_REPROBE_INTERVAL
+#define OPENTHERM_REPROBE_INTERVAL 600000 //ms, retry of unsupported data-ids
+#endif
+
+#ifndef OPENTHERM_RETRY_INTERVAL
+#define OPENTHERM_RETRY_INTERVAL 1000 //ms, first retry of a failed write, doubles with every retry
+#endif
+
+#ifndef OPENTHERM_RETRIES
+#define OPENTHERM_RETRIES 3 //retries of a failed write before it waits for its refresh interval, up to 15
+#endif
+
+#ifndef OPENTHERM_SCHEDULER_TRANSFERS
+#define OPENTHERM_SCHEDULER_TRANSFERS 2
+#endif
+
+class OpenThermScheduler
+{
+private:
+	struct Entry {
+		unsigned long request;
+		unsigned long period; //ms
+		unsigned long lastSent; //ms
+		byte priority;
+		byte flags;
+		void(*handler)(unsigned long, OpenThermResponseStatus);
+	};
+
+	static const unsigned long keepAliveInterval = 900; //ms, master must communicate at least every 1s
+	static const byte NO_ENTRY = 0xFF;
+	static const byte TRANSFER_ENTRY = 0x80; //pending | transfer index
+	static const byte ENTRY_WRITE = 1;
+	static const byte ENTRY_DIRTY = 2; //value changed since last send
+	static const byte ENTRY_CONFIRMED = 4; //WRITE-ACK with current value received
+	static const byte ENTRY_FAILURES = 0xF0; //failed sends of a write since last response or value change
+	static const byte ENTRY_FAILURE = 0x10;
+
+	OpenTherm &ot;
+	Entry entries[OPENTHERM_SCHEDULER_SIZE];
+	byte size;
+	OpenThermTransfer *transfers[OPENTHERM_SCHEDULER_TRANSFERS];
+	byte transferCount;
+	byte nextTransfer;
+	byte pending;
+	unsigned long lastSent;
+
+	unsigned long getPeriod(byte index);
+	byte nextEntry(unsigned long now);
+public:
+	OpenThermScheduler(OpenTherm &ot);
+	int add(unsigned long request, unsigned long period, byte priority = 0, void(*handler)(unsigned long, OpenThermResponseStatus) = NULL);
+	template<OpenThermMessageID ID> int addRead(unsigned long period, byte priority = 0, void(*handler)(unsigned long, OpenThermResponseStatus) = NULL) {
+		return add(OpenTherm::buildReadRequest<ID>(), period, priority, handler);
+	}
+	int addWrite(unsigned long request, unsigned long refresh, byte priority = 0, void(*handler)(unsigned long, OpenThermResponseStatus) = NULL);
+	template<OpenThermMessageID ID> int addWrite(typename OpenThermMessage<ID>::Type value, unsigned long refresh, byte priority = 0, void(*handler)(unsigned long, OpenThermResponseStatus) = NULL) {
+		return addWrite(OpenTherm::buildWriteRequest<ID>(value), refresh, priority, handler);
+	}
+	template<OpenThermMessageID ID> void setValue(int index, typename OpenThermMessage<ID>::Type value) {
+		setRequest(index, OpenTherm::buildWriteRequest<ID>(value));
+	}
+	void setData(int index, unsigned int data);
+	bool isConfirmed(int index);
+	void setRequest(int index, unsigned long request);
+	void setPeriod(int index, unsigned long period);
+	bool addTransfer(OpenThermTransfer &transfer);
+	void process();
+};
+
+#endif // OpenThermScheduler_h
@@ -0,0 +1,207 @@
+/*
+OpenThermTelemetry.cpp - binary frame log for serial links
+*/
+
+#include "OpenThermTelemetry.h"
+
+OpenThermTelemetry::OpenThermTelemetry(Print &out):
+	out(out)
+{
+}
+
+byte OpenThermTelemetry::sourceToCode(char source)
+{
+	switch (source) {
+	case 'B': return 1;
+	case 'R': return 2;
+	case 'A': return 3;
+	default: return 0;
+	}
+}
+
+char OpenThermTelemetry::codeToSource(byte code)
+{
+	static const char sources[] = { 'T', 'B', 'R', 'A' };
+	return sources[code & 3];
+}
+
+void OpenThermTelemetry::write(unsigned long frame, char source, OpenThermResponseStatus status)
+{
+	byte record[OPENTHERM_TELEMETRY_RECORD_SIZE];
+	unsigned long timestamp = millis();
+	record[0] = SYNC;
+	record[1] = (sourceToCode(source) << 4) | status;
+	for (byte i = 0; i < 4; i++) {
+		record[2 + i] = timestamp >> (24 - 8 * i);
+		record[6 + i] = frame >> (24 - 8 * i);
+	}
+	byte checksum = 0;
+	for (byte i = 1; i < OPENTHERM_TELEMETRY_RECORD_SIZE - 1; i++) checksum ^= record[i];
+	record[OPENTHERM_TELEMETRY_RECORD_SIZE - 1] = checksum;
+	out.write(record, OPENTHERM_TELEMETRY_RECORD_SIZE);
+}
+
+//T:OTMessage[READ_DATA,id:89,hi:56,lo:0,TSP setting V/H]:0
+void OpenThermTelemetry::printMessage(Print &out, unsigned long frame, char source)
+{
+	out.print(source);
+	out.print(F(":OTMessage["));
+	out.print(getMessageTypeName(OpenTherm::getMessageType(frame)));
+	out.print(F(",id:"));
+	out.print((byte)OpenTherm::getDataID(frame));
+	out.print(F(",hi:"));
+	out.print(OpenTherm::getDataHB(frame));
+	out.print(F(",lo:"));
+	out.print(OpenTherm::getDataLB(frame));
+	out.print(',');
+	out.print(getMessageName(OpenTherm::getDataID(frame)));
+	out.print(F("]:0"));
+}
+
+const __FlashStringHelper* OpenThermTelemetry::getMessageTypeName(OpenThermMessageType type)
+{
+	switch (type) {
+	case READ_DATA: return F("READ_DATA");
+	case WRITE_DATA: return F("WRITE_DATA");
+	case INVALID_DATA: return F("INVALID_DATA");
+	case RESERVED: return F("RESERVED");
+	case READ_ACK: return F("READ_ACK");
+	case WRITE_ACK: return F("WRITE_ACK");
+	case DATA_INVALID: return F("DATA_INVALID");
+	default: return F("UNKN_DATAID");
+	}
+}
+
+//names as used by gateway logs, strings stay in flash
+const __FlashStringHelper* OpenThermTelemetry::getMessageName(OpenThermMessageID id)
+{
+	switch (id) {
+	case Status: return F("Status");
+	case TSet: return F("Control setpoint");
+	case MConfigMMemberIDcode: return F("Master configuration");
+	case SConfigSMemberIDcode: return F("Slave configuration");
+	case Command: return F("Remote command");
+	case ASFflags: return F("Application-specific fault");
+	case RBPflags: return F("Remote parameter flags");
+	case CoolingControl: return F("Cooling control signal");
+	case TsetCH2: return F("Control setpoint 2");
+	case TrOverride: return F("Remote override room setpoint");
+	case TSP: return F("Number of TSPs");
+	case TSPindexTSPvalue: return F("TSP setting");
+	case FHBsize: return F("Size of fault buffer");
+	case FHBindexFHBvalue: return F("Fault buffer entry");
+	case MaxRelModLevelSetting: return F("Max relative modulation level");
+	case MaxCapacityMinModLevel: return F("Max capacity / min modulation level");
+	case TrSet: return F("Room setpoint");
+	case RelModLevel: return F("Relative modulation level");
+	case CHPressure: return F("CH water pressure");
+	case DHWFlowRate: return F("DHW flow rate");
+	case DayTime: return F("Day of week and time of day");
+	case Date: return F("Date");
+	case Year: return F("Year");
+	case TrSetCH2: return F("Room setpoint CH2");
+	case Tr: return F("Room temperature");
+	case Tboiler: return F("Boiler water temperature");
+	case Tdhw: return F("DHW temperature");
+	case Toutside: return F("Outside temperature");
+	case Tret: return F("Return water temperature");
+	case Tstorage: return F("Solar storage temperature");
+	case Tcollector: return F("Solar collector temperature");
+	case TflowCH2: return F("Flow temperature CH2");
+	case Tdhw2: return F("DHW2 temperature");
+	case Texhaust: return F("Exhaust temperature");
+	case TdhwSetUBTdhwSetLB: return F("DHW setpoint boundaries");
+	case MaxTSetUBMaxTSetLB: return F("Max CH setpoint boundaries");
+	case HcratioUBHcratioLB: return F("OTC heat curve ratio boundaries");
+	case TdhwSet: return F("DHW setpoint");
+	case MaxTSet: return F("Max CH water setpoint");
+	case Hcratio: return F("OTC heat curve ratio");
+	case StatusVH: return F("Status V/H");
+	case ControlSetpointVH: return F("Control setpoint V/H");
+	case FaultFlagsVH: return F("Fault flags/code V/H");
+	case DiagnosticCodeVH: return F("Diagnostic code V/H");
+	case ConfigurationMemberidVH: return F("Configuration/memberid V/H");
+	case OpenThermVersionVH: return F("OpenTherm version V/H");
+	case VersionTypeVH: return F("Version & type V/H");
+	case RelativeVentilationVH: return F("Relative ventilation");
+	case RelativeHumidityVH: return F("Relative humidity");
+	case CO2LevelVH: return F("CO2 level");
+	case TsupplyInletVH: return F("Supply inlet temperature");
+	case TsupplyOutletVH: return F("Supply outlet temperature");
+	case TexhaustInletVH: return F("Exhaust inlet temperature");
+	case TexhaustOutletVH: return F("Exhaust outlet temperature");
+	case ExhaustFanSpeedVH: return F("Exhaust fan speed");
+	case InletFanSpeedVH: return F("Inlet fan speed");
+	case VHRemoteParameterVH: return F("Remote parameter settings V/H");
+	case NominalVentilationVH: return F("Nominal ventilation value");
+	case TSPSizeVH: return F("TSP number V/H");
+	case TspSettingsVH: return F("TSP setting V/H");
+	case FHBSizeVH: return F("Fault buffer size V/H");
+	case FHBIndexVH: return F("Fault buffer entry V/H");
+	case RemoteOverrideFunction: return F("Remote override function");
+	case OEMDiagnosticCode: return F("OEM diagnostic code");
+	case BurnerStarts: return F("Burner starts");
+	case CHPumpStarts: return F("CH pump starts");
+	case DHWPumpValveStarts: return F("DHW pump/valve starts");
+	case DHWBurnerStarts: return F("DHW burner starts");
+	case BurnerOperationHours: return F("Burner operation hours");
+	case CHPumpOperationHours: return F("CH pump operation hours");
+	case DHWPumpValveOperationHours: return F("DHW pump/valve operation hours");
+	case DHWBurnerOperationHours: return F("DHW burner operation hours");
+	case OpenThermVersionMaster: return F("OpenTherm version master");
+	case OpenThermVersionSlave: return F("OpenTherm version slave");
+	case MasterVersion: return F("Master product version");
+	case SlaveVersion: return F("Slave product version");
+	default: return F("Unknown");
+	}
+}
+
+OpenThermTelemetryReader::OpenThermTelemetryReader(void(*callback)(const OpenThermTelemetryRecord&)):
+	count(0),
+	errorCount(0),
+	callback(callback)
+{
+}
+
+bool OpenThermTelemetryReader::decode(OpenThermTelemetryRecord &record)
+{
+	byte checksum = 0;
+	for (byte i = 1; i < OPENTHERM_TELEMETRY_RECORD_SIZE - 1; i++) checksum ^= buffer[i];
+	if (checksum != buffer[OPENTHERM_TELEMETRY_RECORD_SIZE - 1] || (buffer[1] & 0x0F) > DATA_REJECTED || buffer[1] > 0x3F) return false;
+	record.source = OpenThermTelemetry::codeToSource(buffer[1] >> 4);
+	record.status = (OpenThermResponseStatus)(buffer[1] & 0x0F);
+	record.timestamp = 0;
+	record.frame = 0;
+	for (byte i = 0; i < 4; i++) {
+		record.timestamp = (record.timestamp << 8) | buffer[2 + i];
+		record.frame = (record.frame << 8) | buffer[6 + i];
+	}
+	return true;
+}
+
+//on checksum error decoding restarts at the next sync byte in the buffer
+size_t OpenThermTelemetryReader::write(uint8_t c)
+{
+	if (count == 0 && c != OpenThermTelemetry::SYNC) return 1;
+	buffer[count++] = c;
+	if (count < OPENTHERM_TELEMETRY_RECORD_SIZE) return 1;
+
+	OpenThermTelemetryRecord record;
+	if (decode(record)) {
+		count = 0;
+		if (callback != NULL) callback(record);
+		return 1;
+	}
+	errorCount++;
+	byte start = 1;
+	while (start < count && buffer[start] != OpenThermTelemetry::SYNC) start++;
+	count -= start;
+	memmove(buffer, buffer + start, count);
+	return 1;
+}
+
+//records dropped because of checksum errors
+unsigned long OpenThermTelemetryReader::getErrorCount()
+{
+	return errorCount;
+}
@@ -0,0 +1,59 @@
+/*
+OpenThermTelemetry.h - binary frame log for serial links
+Every frame is written as one 11 byte record from a fixed buffer, no heap is used:
+0xA5, source << 4 | status, millis (4 bytes), frame (4 bytes), checksum (xor of bytes 1..9)
+Source is T (request), B (response), R or A (frames changed by gateway) like in gateway logs.
+OpenThermTelemetryReader decodes records written to it (resynchronizes on sync byte and checksum),
+printMessage renders a frame as gateway log text: T:OTMessage[READ_DATA,id:89,hi:56,lo:0,TSP setting V/H]:0
+*/
+
+#ifndef OpenThermTelemetry_h
+#define OpenThermTelemetry_h
+
+#include "OpenTherm.h"
+
+#define OPENTHERM_TELEMETRY_RECORD_SIZE 11
+
+struct OpenThermTelemetryRecord {
+	unsigned long timestamp; //ms
+	unsigned long frame;
+	char source;
+	OpenThermResponseStatus status;
+};
+
+class OpenThermTelemetry
+{
+private:
+	static const byte SYNC = 0xA5;
+
+	Print &out;
+
+	friend class OpenThermTelemetryReader;
+	static byte sourceToCode(char source);
+	static char codeToSource(byte code);
+public:
+	OpenThermTelemetry(Print &out);
+	void write(unsigned long frame, char source, OpenThermResponseStatus status = OpenThermResponseStatus::SUCCESS);
+
+	static void printMessage(Print &out, unsigned long frame, char source);
+	static const __FlashStringHelper* getMessageTypeName(OpenThermMessageType type);
+	static const __FlashStringHelper* getMessageName(OpenThermMessageID id);
+};
+
+class OpenThermTelemetryReader : public Print
+{
+private:
+	byte buffer[OPENTHERM_TELEMETRY_RECORD_SIZE];
+	byte count;
+	unsigned long errorCount;
+	void(*callback)(const OpenThermTelemetryRecord&);
+
+	bool decode(OpenThermTelemetryRecord &record);
+public:
+	OpenThermTelemetryReader(void(*callback)(const OpenThermTelemetryRecord &record));
+	virtual size_t write(uint8_t c);
+	using Print::write;
+	unsigned long getErrorCount();
+};
+
+#endif // OpenThermTelemetry_h
@@ -0,0 +1,123 @@
+/*
+OpenThermTransfer.cpp - bulk read of transparent slave parameters (TSP) and fault history buffer (FHB)
+*/
+
+#include "OpenThermTransfer.h"
+
+//size 0 - read from sizeId (hb), starts on first idle slot
+OpenThermTransfer::OpenThermTransfer(OpenThermMessageID sizeId, OpenThermMessageID entryId, byte size, void(*changeCallback)(OpenThermMessageID, byte, byte)):
+	sizeId(sizeId),
+	entryId(entryId),
+	fixedSize(size < OPENTHERM_TRANSFER_SIZE ? size : OPENTHERM_TRANSFER_SIZE),
+	size(0),
+	state(TRANSFER_IDLE),
+	index(0),
+	retries(0),
+	interval(0),
+	startTimestamp(0),
+	duration(0),
+	changeCallback(changeCallback)
+{
+	memset(valid, 0, sizeof(valid));
+	start();
+}
+
+void OpenThermTransfer::start()
+{
+	startTimestamp = millis();
+	index = 0;
+	retries = 0;
+	size = fixedSize;
+	state = size > 0 ? TRANSFER_ENTRIES : TRANSFER_SIZE;
+}
+
+//table is read again interval ms after previous start
+void OpenThermTransfer::setInterval(unsigned long interval)
+{
+	this->interval = interval;
+}
+
+bool OpenThermTransfer::isRunning()
+{
+	return state != TRANSFER_IDLE;
+}
+
+byte OpenThermTransfer::getSize()
+{
+	return size;
+}
+
+bool OpenThermTransfer::isValid(byte index)
+{
+	return index < OPENTHERM_TRANSFER_SIZE && (valid[index >> 3] & (1 << (index & 7)));
+}
+
+byte OpenThermTransfer::getValue(byte index)
+{
+	return isValid(index) ? values[index] : 0;
+}
+
+//ms of last full read
+unsigned long OpenThermTransfer::getDuration()
+{
+	return duration;
+}
+
+bool OpenThermTransfer::nextRequest(unsigned long &request)
+{
+	if (state == TRANSFER_IDLE) {
+		if (interval == 0 || millis() - startTimestamp < interval) return false;
+		start();
+	}
+	if (state == TRANSFER_SIZE) {
+		request = OpenTherm::buildRequest(OpenThermRequestType::READ, sizeId, 0);
+	}
+	else {
+		request = OpenTherm::buildRequest(OpenThermRequestType::READ, entryId, (unsigned int)index << 8);
+	}
+	return true;
+}
+
+void OpenThermTransfer::nextIndex()
+{
+	retries = 0;
+	if (++index < size) return;
+	state = TRANSFER_IDLE;
+	duration = millis() - startTimestamp;
+}
+
+//unsupported index (DATA-INVALID) is skipped, failed reads are retried
+void OpenThermTransfer::handleResponse(unsigned long response, OpenThermResponseStatus status)
+{
+	bool unsupported = status == OpenThermResponseStatus::UNKNOWN_ID || status == OpenThermResponseStatus::DATA_REJECTED;
+	if (state == TRANSFER_SIZE) {
+		if (status == OpenThermResponseStatus::SUCCESS) {
+			size = OpenTherm::getDataHB(response);
+			if (size > OPENTHERM_TRANSFER_SIZE) size = OPENTHERM_TRANSFER_SIZE;
+			state = size > 0 ? TRANSFER_ENTRIES : TRANSFER_IDLE;
+			retries = 0;
+		}
+		else if (unsupported || ++retries > maxRetries) {
+			state = TRANSFER_IDLE;
+		}
+		return;
+	}
+	if (state != TRANSFER_ENTRIES) return;
+
+	if (status == OpenThermResponseStatus::SUCCESS && OpenTherm::getDataHB(response) == index) {
+		byte value = OpenTherm::getDataLB(response);
+		byte mask = 1 << (index & 7);
+		if (!(valid[index >> 3] & mask) || values[index] != value) {
+			values[index] = value;
+			valid[index >> 3] |= mask;
+			if (changeCallback != NULL) {
+				changeCallback(entryId, index, value);
+			}
+		}
+		nextIndex();
+	}
+	else if (unsupported || ++retries > maxRetries) {
+		valid[index >> 3] &= ~(1 << (index & 7));
+		nextIndex();
+	}
+}
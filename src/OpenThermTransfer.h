@@ -0,0 +1,61 @@
+/*
+OpenThermTransfer.h - bulk read of transparent slave parameters (TSP) and fault history buffer (FHB)
+Reads the table size (unless given) and then all entries index by index into a compact shadow copy.
+Requests are sent by OpenThermScheduler in slots where no scheduled request is due, so a full table
+takes size * (frame time + 100ms delay) instead of one entry per poll cycle.
+Only entries which are read for the first time or changed are passed to the change callback.
+Tables: TSP/TSPindexTSPvalue (10/11), FHBsize/FHBindexFHBvalue (12/13),
+TSPSizeVH/TspSettingsVH (88/89), FHBSizeVH/FHBIndexVH (90/91).
+*/
+
+#ifndef OpenThermTransfer_h
+#define OpenThermTransfer_h
+
+#include "OpenTherm.h"
+
+#ifndef OPENTHERM_TRANSFER_SIZE
+#define OPENTHERM_TRANSFER_SIZE 64 //max entries of a table
+#endif
+
+class OpenThermTransfer
+{
+private:
+	enum TransferState {
+		TRANSFER_IDLE,
+		TRANSFER_SIZE,
+		TRANSFER_ENTRIES
+	};
+
+	static const byte maxRetries = 3;
+
+	const OpenThermMessageID sizeId;
+	const OpenThermMessageID entryId;
+	const byte fixedSize;
+	byte size;
+	byte state;
+	byte index;
+	byte retries;
+	unsigned long interval; //ms, 0 - only on start
+	unsigned long startTimestamp; //ms
+	unsigned long duration; //ms, last full refresh
+	byte values[OPENTHERM_TRANSFER_SIZE];
+	byte valid[(OPENTHERM_TRANSFER_SIZE + 7) / 8];
+	void(*changeCallback)(OpenThermMessageID, byte, byte);
+
+	void nextIndex();
+public:
+	OpenThermTransfer(OpenThermMessageID sizeId, OpenThermMessageID entryId, byte size = 0, void(*changeCallback)(OpenThermMessageID id, byte index, byte value) = NULL);
+	void start();
+	void setInterval(unsigned long interval);
+	bool isRunning();
+	byte getSize();
+	bool isValid(byte index);
+	byte getValue(byte index);
+	unsigned long getDuration();
+
+	//used by OpenThermScheduler
+	bool nextRequest(unsigned long &request);
+	void handleResponse(unsigned long response, OpenThermResponseStatus status);
+};
+
+#endif // OpenThermTransfer_h